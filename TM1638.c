@@ -4,12 +4,15 @@
  *
  * This file provides the implementation for driving TM1638-based modules,
  * which typically include 8 seven-segment displays, 8 dual-color LEDs, and a keypad.
- * This driver is designed to work with STM32 HAL libraries.
+ * The protocol logic only talks to the bus through a TM1638_Transport; the
+ * STM32 HAL transports at the end of this file are left out when
+ * TM1638_NO_HAL is defined.
  *
  * @version 1.1
  * @date 2025-10-05
  */
 #include "TM1638.h"
+#include "TM1638_font.h"
 #include <string.h>
 #include <math.h> // Used in tm1638_Draw, though bit-shifting is preferred.
 
@@ -23,6 +26,7 @@
  * - 0x44: Write data to display register, fixed address.
  */
 static const uint8_t CMD_DATA_SET_AUTO_INC = 0x40;
+static const uint8_t CMD_DATA_SET_FIXED = 0x44;
 
 /** @brief Command to read key scan data. */
 static const uint8_t CMD_DATA_READ = 0x42;
@@ -40,66 +44,89 @@ static const uint8_t CMD_DISPLAY_CTRL = 0x80;
 static const uint8_t DISPLAY_ON_MASK = 0x08;
 static const uint8_t DISPLAY_BRIGHTNESS_MASK = 0x07;
 
+/**
+ * @brief 7-segment codes for the 128 ASCII characters, indexed by character.
+ *
+ * Control characters are blank. Letters that a 7-segment digit cannot show
+ * exactly use the closest common shape (e.g. 'K' like 'H' with an open top,
+ * 'M' and 'W' as three-stroke approximations, 'X' like 'H').
+ */
+static const uint8_t SEGMENT_FONT[128] = TM1638_FONT_INITIALIZER;
 
-// --- Private Function Prototypes ---
+/** @brief Number of display registers (8 segment + 8 LED, interleaved). */
+#define TM1638_RAM_SIZE 16
 
-// Low-level GPIO pin control functions
-static void tm1638_sdo_high(TM1638 *tm);
-static void tm1638_sdo_low(TM1638 *tm);
-static void tm1638_stb_high(TM1638 *tm);
-static void tm1638_stb_low(TM1638 *tm);
-static void tm1638_clk_high(TM1638 *tm);
-static void tm1638_clk_low(TM1638 *tm);
+/** @brief Slowest CLK low/high time tried by tm1638_calibrate_timing(), halved at each step. */
+#define TM1638_CAL_SLOWEST_NS 3200
+
+/** @brief Datasheet floor of the CLK low/high time (1 MHz clock): the last step tried. */
+#define TM1638_CAL_FASTEST_NS 400
+
+/** @brief Key reads that must all be valid and agree for a calibration step to pass. */
+#define TM1638_CAL_READS 8
+
+#ifdef TM1638_ENABLE_STATS
+#ifndef TM1638_CYCLES
+#ifndef TM1638_NO_HAL
+#define TM1638_CYCLES() (DWT->CYCCNT)
+#else
+#define TM1638_CYCLES() 0U
+#endif
+#endif
+#endif
+
+/*
+ * Board profiles: matrix bit of each key. KS(2n+1) and KS(2n+2) are in byte
+ * n, bits 0-2 and 4-6 (K3, K2, K1). The keys of both boards scan down the
+ * odd KS lines first, then the even ones.
+ */
+const TM1638_Board tm1638_board_led_key = {
+    .key_count = 8,
+    .key_bit = { 1, 9, 17, 25, 5, 13, 21, 29 }, // K2
+};
+
+const TM1638_Board tm1638_board_qyf = {
+    .key_count = 16,
+    .key_bit = { 1, 9, 17, 25, 5, 13, 21, 29,   // S1-S8 on K2
+                 0, 8, 16, 24, 4, 12, 20, 28 }, // S9-S16 on K3
+};
+
+
+// --- Private Function Prototypes ---
 
 // Communication protocol functions
-static void tm1638_start_transmission(TM1638 *tm);
-static void tm1638_end_transmission(TM1638 *tm);
-static void tm1638_send_data(TM1638 *tm, uint8_t data);
 static void tm1638_send_command(TM1638 *tm, uint8_t cmd);
+static void tm1638_send_frame(TM1638 *tm, const uint8_t *frame, uint8_t len);
 
-// Helper function to get 7-segment font code
-static uint8_t char_to_segment_code(char c);
+// Bus helpers
+static void tm1638_setup(TM1638 *tm, const TM1638_Transport *transport, uint8_t brightness);
+static void tm1638_bus_broadcast(TM1638_Bus *bus, const uint8_t *frame, uint8_t len);
 
+// Framebuffer helper
+static void tm1638_ram_write(TM1638 *tm, uint8_t address, uint8_t value);
 
-// --- GPIO Control Implementation ---
+// Key input
+static uint32_t tm1638_read_keys(TM1638 *tm);
+static void tm1638_queue_event(TM1638_Keypad *kp, uint8_t key, TM1638_KeyEventType type, uint32_t time_ms);
+#ifndef TM1638_NO_HAL
+static void tm1638_sleep_until(uint32_t tick);
 
-static void tm1638_sdo_high(TM1638 *tm) {
-    HAL_GPIO_WritePin(tm->dio_port, tm->dio_pin, GPIO_PIN_SET);
-}
-static void tm1638_sdo_low(TM1638 *tm) {
-    HAL_GPIO_WritePin(tm->dio_port, tm->dio_pin, GPIO_PIN_RESET);
-}
-static void tm1638_stb_high(TM1638 *tm) {
-    HAL_GPIO_WritePin(tm->stb_port, tm->stb_pin, GPIO_PIN_SET);
-}
-static void tm1638_stb_low(TM1638 *tm) {
-    HAL_GPIO_WritePin(tm->stb_port, tm->stb_pin, GPIO_PIN_RESET);
-}
-static void tm1638_clk_high(TM1638 *tm) {
-    HAL_GPIO_WritePin(tm->clk_port, tm->clk_pin, GPIO_PIN_SET);
-}
-static void tm1638_clk_low(TM1638 *tm) {
-    HAL_GPIO_WritePin(tm->clk_port, tm->clk_pin, GPIO_PIN_RESET);
-}
+// Bit timing
+static uint16_t tm1638_ns_to_cycles(uint32_t ns);
+static bool tm1638_timing_ok(TM1638 *tm);
+#endif
 
+// Helper function to get 7-segment font code
+static uint8_t char_to_segment_code(char c);
 
-// --- Communication Protocol Implementation ---
+#ifdef TM1638_ENABLE_STATS
+// Runtime statistics
+static void tm1638_stats_op(TM1638_OpStats *op, uint32_t start);
+static void tm1638_stats_bus(TM1638 *tm, uint32_t sent, uint32_t received);
+#endif
 
-/**
- * @brief Initiates a data transmission sequence by pulling STB low.
- * @param tm Pointer to the TM1638 handle.
- */
-static void tm1638_start_transmission(TM1638 *tm) {
-    tm1638_stb_low(tm);
-}
 
-/**
- * @brief Terminates a data transmission sequence by pulling STB high.
- * @param tm Pointer to the TM1638 handle.
- */
-static void tm1638_end_transmission(TM1638 *tm) {
-    tm1638_stb_high(tm);
-}
+// --- Communication Protocol Implementation ---
 
 /**
  * @brief Sends a single command byte to the TM1638.
@@ -107,42 +134,63 @@ static void tm1638_end_transmission(TM1638 *tm) {
  * @param cmd The command byte to send.
  */
 static void tm1638_send_command(TM1638 *tm, uint8_t cmd) {
-    tm1638_start_transmission(tm);
-    tm1638_send_data(tm, cmd);
-    tm1638_end_transmission(tm);
+    tm->transport->begin(tm);
+    tm->transport->write(tm, &cmd, 1);
+    tm->transport->end(tm);
+#ifdef TM1638_ENABLE_STATS
+    tm1638_stats_bus(tm, 1, 0);
+#endif
 }
 
 /**
- * @brief Sends a byte of data to the TM1638, LSB first.
+ * @brief Sends a complete STB-framed transaction.
+ *
+ * Transports that can move a whole frame in the background (DMA) provide
+ * send_frame; the others get the usual begin/write/end sequence.
+ *
  * @param tm Pointer to the TM1638 handle.
- * @param data The byte of data to send.
+ * @param frame Bytes to send (first byte is the command or address).
+ * @param len Number of bytes in the frame (at most TM1638_MAX_FRAME_SIZE).
  */
-static void tm1638_send_data(TM1638 *tm, uint8_t data) {
-    for (uint8_t i = 0; i < 8; i++) {
-        tm1638_clk_low(tm);
-        // Set data pin high or low based on the current bit (LSB first)
-        if (data & 0x01) {
-            tm1638_sdo_high(tm);
-        } else {
-            tm1638_sdo_low(tm);
-        }
-        // Right-shift data to process the next bit in the next iteration
-        data >>= 1;
-        tm1638_clk_high(tm);
+static void tm1638_send_frame(TM1638 *tm, const uint8_t *frame, uint8_t len) {
+#ifdef TM1638_ENABLE_STATS
+    tm1638_stats_bus(tm, len, 0);
+#endif
+    if (tm->transport->send_frame != NULL) {
+        tm->transport->send_frame(tm, frame, len);
+        return;
     }
+    tm->transport->begin(tm);
+    tm->transport->write(tm, frame, len);
+    tm->transport->end(tm);
 }
 
 
 // --- Public Function Implementation ---
 
+#ifndef TM1638_NO_HAL
 /**
- * @brief Initializes the TM1638 module, clears the display, and sets brightness.
+ * @brief Initializes the TM1638 module using the transport chosen by TM1638_BACKEND.
  * @param tm Pointer to the TM1638 handle.
  * @param brightness Initial brightness level (0-7).
  */
 void tm1638_init(TM1638 *tm, uint8_t brightness) {
-    tm->brightness = brightness & DISPLAY_BRIGHTNESS_MASK; // Ensure brightness is within 0-7
-    tm1638_display_clear(tm);
+    tm1638_init_transport(tm, &TM1638_DEFAULT_TRANSPORT, brightness);
+}
+#endif
+
+/**
+ * @brief Initializes the TM1638 module, clears the display, and sets brightness.
+ * @param tm Pointer to the TM1638 handle.
+ * @param transport The bus implementation to use.
+ * @param brightness Initial brightness level (0-7).
+ */
+void tm1638_init_transport(TM1638 *tm, const TM1638_Transport *transport, uint8_t brightness) {
+    tm1638_setup(tm, transport, brightness);
+
+    // The chip RAM content is unknown after power-up, so push every register once
+    tm->dirty = 0xFFFF;
+    tm1638_flush(tm);
     tm1638_set_brightness(tm, tm->brightness);
 }
 
@@ -156,10 +204,16 @@ void tm1638_set_brightness(TM1638 *tm, uint8_t brightness) {
         // Clamp brightness to the maximum value if out of range
         brightness = 7;
     }
+#ifdef TM1638_ENABLE_STATS
+    uint32_t start = TM1638_CYCLES();
+#endif
     tm->brightness = brightness;
     // Command is 0x88-0x8F for display on with brightness
     uint8_t command = CMD_DISPLAY_CTRL | DISPLAY_ON_MASK | brightness;
     tm1638_send_command(tm, command);
+#ifdef TM1638_ENABLE_STATS
+    tm1638_stats_op(&tm->stats.brightness, start);
+#endif
 }
 
 /**
@@ -167,17 +221,10 @@ void tm1638_set_brightness(TM1638 *tm, uint8_t brightness) {
  * @param tm Pointer to the TM1638 handle.
  */
 void tm1638_display_clear(TM1638 *tm) {
-    // Set to auto-increment address mode
-    tm1638_send_command(tm, CMD_DATA_SET_AUTO_INC);
-
-    tm1638_start_transmission(tm);
-    // Start writing from address 0x00
-    tm1638_send_data(tm, CMD_ADDRESS_SET);
     // Write 0x00 to all 16 registers (8 for segments, 8 for LEDs)
-    for (uint8_t i = 0; i < 16; i++) {
-        tm1638_send_data(tm, 0x00);
+    for (uint8_t i = 0; i < TM1638_RAM_SIZE; i++) {
+        tm1638_ram_write(tm, i, 0x00);
     }
-    tm1638_end_transmission(tm);
 }
 
 /**
@@ -246,12 +293,7 @@ void tm1638_set_led(TM1638 *tm, uint8_t position, bool on) {
         return; // Invalid position
     }
     // LED addresses are the odd-numbered registers (1, 3, 5, ...)
-    uint8_t address = CMD_ADDRESS_SET + (2 * position) - 1;
-
-    tm1638_start_transmission(tm);
-    tm1638_send_data(tm, address);
-    tm1638_send_data(tm, on ? 0x01 : 0x00);
-    tm1638_end_transmission(tm);
+    tm1638_ram_write(tm, (2 * position) - 1, on ? 0x01 : 0x00);
 }
 
 /**
@@ -265,72 +307,157 @@ void tm1638_set_segment(TM1638 *tm, uint8_t position, uint8_t data) {
         return; // Invalid position
     }
     // Segment addresses are the even-numbered registers (0, 2, 4, ...)
-    uint8_t address = CMD_ADDRESS_SET + (2 * (position - 1));
-
-    tm1638_start_transmission(tm);
-    tm1638_send_data(tm, address);
-    tm1638_send_data(tm, data);
-    tm1638_end_transmission(tm);
+    tm1638_ram_write(tm, 2 * (position - 1), data);
 }
 
-
 /**
- * @brief Scans the keypad and returns a bitmask of pressed buttons.
+ * @brief Sets all 8 digits from prebuilt segment codes.
  * @param tm Pointer to the TM1638 handle.
- * @return A bitmask where bit 0 corresponds to S1, bit 1 to S2, etc.
+ * @param segments Segment codes for positions 1-8.
  */
-uint8_t tm1638_scan_buttons(TM1638 *tm) {
-    uint32_t raw_key_data = 0;
-    uint8_t pressed_keys = 0;
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
+void tm1638_display_raw8(TM1638 *tm, const uint8_t segments[8]) {
+    for (uint8_t i = 0; i < 8; i++) {
+        // Segment addresses are the even-numbered registers (0, 2, 4, ...)
+        tm1638_ram_write(tm, 2 * i, segments[i]);
+    }
+}
 
-    tm1638_start_transmission(tm);
-    tm1638_send_data(tm, CMD_DATA_READ);
+/**
+ * @brief Sends the dirty framebuffer registers to the TM1638.
+ *
+ * The dirty registers are grouped into runs. Two neighbouring runs are merged
+ * (rewriting the unchanged registers between them) when that clocks fewer bits
+ * than opening a new transaction for the second run. Since every gap is
+ * decided independently this yields the cheapest plan, which degenerates into
+ * one auto-increment burst for dense updates. When every run ends up holding a
+ * single register, fixed-address mode is used for the individual writes.
+ *
+ * @param tm Pointer to the TM1638 handle.
+ */
+void tm1638_flush(TM1638 *tm) {
+    uint8_t run_start[TM1638_RAM_SIZE];
+    uint8_t run_len[TM1638_RAM_SIZE];
+    uint8_t runs = 0;
+    uint8_t dirty_count = 0;
+    uint8_t last = 0;
+    // One STB cycle plus the address byte, in clocked bits
+    const uint16_t transaction_cost = tm->transport->stb_cycle_cost + 8;
 
-    // Temporarily set DIO pin as input to read data from TM1638
-    GPIO_InitStruct.Pin = tm->dio_pin;
-    GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
-    GPIO_InitStruct.Pull = GPIO_PULLUP; // Use pull-up to ensure stable line
-    HAL_GPIO_Init(tm->dio_port, &GPIO_InitStruct);
+    if (tm->dirty == 0) {
+        return; // Nothing changed since the last flush
+    }
+#ifdef TM1638_ENABLE_STATS
+    uint32_t start = TM1638_CYCLES();
+#endif
 
-    // Read the 4 bytes (32 bits) of key scan data
-    for (int8_t i = 0; i < 32; i++) {
-        tm1638_clk_low(tm);
-        // HAL_Delay(1); // Small delay may be needed on very fast MCUs
-        if (HAL_GPIO_ReadPin(tm->dio_port, tm->dio_pin) == GPIO_PIN_SET) {
-            raw_key_data |= (1UL << i);
+    for (uint8_t i = 0; i < TM1638_RAM_SIZE; i++) {
+        if (!(tm->dirty & (1U << i))) {
+            continue;
         }
-        tm1638_clk_high(tm);
+        dirty_count++;
+        // Bridge the gap if resending it is not dearer than a new transaction
+        if (runs > 0 && (i - last - 1) * 8 <= transaction_cost) {
+            run_len[runs - 1] = i - run_start[runs - 1] + 1;
+        } else {
+            run_start[runs] = i;
+            run_len[runs] = 1;
+            runs++;
+        }
+        last = i;
     }
-    tm1638_end_transmission(tm);
 
-    // Restore DIO pin to output push-pull mode
-    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
-    GPIO_InitStruct.Pull = GPIO_NOPULL;
-    HAL_GPIO_Init(tm->dio_port, &GPIO_InitStruct);
+    // Isolated registers: same bus cost either way, use the mode meant for it
+    tm1638_send_command(tm, (runs == dirty_count) ? CMD_DATA_SET_FIXED : CMD_DATA_SET_AUTO_INC);
+
+    for (uint8_t r = 0; r < runs; r++) {
+        uint8_t frame[TM1638_RAM_SIZE + 1];
+        frame[0] = CMD_ADDRESS_SET | run_start[r];
+        memcpy(&frame[1], &tm->display_ram[run_start[r]], run_len[r]);
+        tm1638_send_frame(tm, frame, run_len[r] + 1);
+    }
+    tm->dirty = 0;
+#ifdef TM1638_ENABLE_STATS
+    tm1638_stats_op(&tm->stats.flush, start);
+#endif
+}
+
+#ifdef TM1638_ENABLE_STATS
+/**
+ * @brief Copies the runtime statistics of a handle.
+ * @param tm Pointer to the TM1638 handle.
+ * @param stats Receives the statistics.
+ */
+void tm1638_get_stats(const TM1638 *tm, TM1638_Stats *stats) {
+    *stats = tm->stats;
+}
+
+/**
+ * @brief Clears the runtime statistics of a handle.
+ * @param tm Pointer to the TM1638 handle.
+ */
+void tm1638_reset_stats(TM1638 *tm) {
+    memset(&tm->stats, 0, sizeof(tm->stats));
+    tm->stats.flush.min_cycles = UINT32_MAX;
+    tm->stats.scan.min_cycles = UINT32_MAX;
+    tm->stats.brightness.min_cycles = UINT32_MAX;
+}
+#endif
+
+/**
+ * @brief Scans the keypad and returns a bitmask of pressed buttons.
+ * @param tm Pointer to the TM1638 handle.
+ * @return A bitmask where bit 0 corresponds to S1, bit 1 to S2, etc.
+ */
+uint8_t tm1638_scan_buttons(TM1638 *tm) {
+    uint32_t raw_key_data = tm1638_read_keys(tm);
+    uint32_t low, high;
+    uint8_t pressed_keys;
 
     /*
      * The TM1638 returns key data in a specific pattern across the 4 bytes.
-     * K1 keys (S1, S5) are in the 1st and 3rd bits of each byte.
-     * K2 keys (S2, S6) are in the 2nd and 4th bits.
-     * And so on.
+     * Byte n holds S(n+1) in bit 1 and S(n+5) in bit 5:
      * Bit 1 -> S1, Bit 5 -> S5
      * Bit 9 -> S2, Bit 13 -> S6
      * Bit 17 -> S3, Bit 21 -> S7
      * Bit 25 -> S4, Bit 29 -> S8
+     *
+     * Masking one column leaves a bit at 0, 8, 16 and 24. Multiplying by
+     * 0x01020408 shifts these by 24, 17, 10 and 3, which gathers them in bits
+     * 24-27; the other partial products land below bit 24 or above bit 31
+     * and never overlap, so no carry reaches the result.
      */
-    if (raw_key_data & (1UL << 1)) pressed_keys |= (1 << 0);  // S1
-    if (raw_key_data & (1UL << 9)) pressed_keys |= (1 << 1);  // S2
-    if (raw_key_data & (1UL << 17)) pressed_keys |= (1 << 2); // S3
-    if (raw_key_data & (1UL << 25)) pressed_keys |= (1 << 3); // S4
-    if (raw_key_data & (1UL << 5)) pressed_keys |= (1 << 4);  // S5
-    if (raw_key_data & (1UL << 13)) pressed_keys |= (1 << 5); // S6
-    if (raw_key_data & (1UL << 21)) pressed_keys |= (1 << 6); // S7
-    if (raw_key_data & (1UL << 29)) pressed_keys |= (1 << 7); // S8
+    low = (raw_key_data >> 1) & 0x01010101UL;  // S1-S4
+    high = (raw_key_data >> 5) & 0x01010101UL; // S5-S8
+    pressed_keys = (uint8_t)(((low * 0x01020408UL) >> 24) & 0x0F)
+                 | (uint8_t)((((high * 0x01020408UL) >> 24) & 0x0F) << 4);
 
     return pressed_keys;
 }
 
+/**
+ * @brief Reads the whole key matrix.
+ * @param tm Pointer to the TM1638 handle.
+ * @return The 32-bit matrix bitmap.
+ */
+uint32_t tm1638_scan_matrix(TM1638 *tm) {
+    return tm1638_read_keys(tm);
+}
+
+/**
+ * @brief Converts a matrix bitmap into the keys of a board.
+ * @param board The board profile.
+ * @param matrix Bitmap returned by tm1638_scan_matrix().
+ * @return Bit i is set when key S(i+1) is pressed.
+ */
+uint32_t tm1638_map_keys(const TM1638_Board *board, uint32_t matrix) {
+    uint32_t keys = 0;
+    for (uint8_t i = 0; i < board->key_count; i++) {
+        keys |= ((matrix >> board->key_bit[i]) & 1UL) << i;
+    }
+    return keys;
+}
+
+#ifndef TM1638_NO_HAL
 /**
  * @brief Waits until a key is pressed and returns its number (1-8).
  * @param tm Pointer to the TM1638 handle.
@@ -340,12 +467,12 @@ uint8_t tm1638_read_key_blocking(TM1638 *tm) {
     uint8_t buttons = 0;
     // Wait for a key press
     while ((buttons = tm1638_scan_buttons(tm)) == 0) {
-        HAL_Delay(20); // Polling delay to reduce CPU usage
+        tm1638_sleep_until(HAL_GetTick() + 20); // Polling delay, with the core asleep
     }
 
     // Debounce: wait for key release
     while (tm1638_scan_buttons(tm) != 0) {
-        HAL_Delay(20);
+        tm1638_sleep_until(HAL_GetTick() + 20);
     }
     
     // Convert bitmask to key number (1-8)
@@ -357,66 +484,1363 @@ uint8_t tm1638_read_key_blocking(TM1638 *tm) {
     return 0; // Should not be reached if one key was pressed
 }
 
+/**
+ * @brief Sets the CLK low and high times of the bit-banged transports.
+ * @param tm Pointer to the TM1638 handle.
+ * @param low_ns Extra CLK low time in nanoseconds.
+ * @param high_ns Extra CLK high time in nanoseconds.
+ */
+void tm1638_set_timing(TM1638 *tm, uint32_t low_ns, uint32_t high_ns) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    tm->clk_low_cycles = tm1638_ns_to_cycles(low_ns);
+    tm->clk_high_cycles = tm1638_ns_to_cycles(high_ns);
+}
 
-// --- Private Helper Function Implementation ---
+/**
+ * @brief Finds the fastest reliable clock and sets it with a safety margin.
+ * @param tm Pointer to an initialized TM1638 handle.
+ * @param margin_percent Safety margin added to the shortest passing time.
+ * @return The CLK low/high time kept in nanoseconds, or UINT32_MAX if nothing passed.
+ */
+uint32_t tm1638_calibrate_timing(TM1638 *tm, uint8_t margin_percent) {
+    uint32_t step = TM1638_CAL_SLOWEST_NS;
+    uint32_t passed = UINT32_MAX;
+    uint32_t result;
+
+    // Faster than the datasheet's clock is never kept, even if the reads pass
+    for (;;) {
+        tm1638_set_timing(tm, step, step);
+        if (!tm1638_timing_ok(tm)) {
+            break;
+        }
+        passed = step;
+        if (step <= TM1638_CAL_FASTEST_NS) {
+            break;
+        }
+        step /= 2;
+    }
+
+    if (passed == UINT32_MAX) {
+        result = UINT32_MAX;
+        tm1638_set_timing(tm, TM1638_CAL_SLOWEST_NS, TM1638_CAL_SLOWEST_NS);
+    } else {
+        result = passed + passed * margin_percent / 100U;
+        tm1638_set_timing(tm, result, result);
+    }
+
+    // Failed steps may have garbled commands, so restore the whole chip state
+    tm->dirty = 0xFFFF;
+    tm1638_flush(tm);
+    tm1638_set_brightness(tm, tm->brightness);
+    return result;
+}
+#endif
+
+
+// --- Multi-Module Bus Implementation ---
 
 /**
- * @brief Converts a character to its 7-segment display hexadecimal code.
+ * @brief Initializes a bus of modules sharing CLK and DIO.
+ * @param bus Pointer to the bus object.
+ * @param modules Array of count module handles.
+ * @param count Number of modules on the bus.
+ * @param transport The bus implementation shared by all modules.
+ * @param brightness Initial brightness level (0-7).
+ * @return true on success, false if the transport sends frames asynchronously.
+ */
+bool tm1638_bus_init(TM1638_Bus *bus, TM1638 *modules, uint8_t count,
+                     const TM1638_Transport *transport, uint8_t brightness) {
+    bus->modules = modules;
+    bus->count = 0;
+
+    // A frame still in flight on one handle would be cut by another module's
+    // STB: busy state and peripheral handles are per module, not per bus
+    if (transport->send_frame != NULL) {
+        return false;
+    }
+    bus->count = count;
+
+    for (uint8_t i = 0; i < count; i++) {
+#ifndef TM1638_NO_HAL
+        // Only the STB line differs between modules
+        modules[i].clk_port = modules[0].clk_port;
+        modules[i].clk_pin = modules[0].clk_pin;
+        modules[i].dio_port = modules[0].dio_port;
+        modules[i].dio_pin = modules[0].dio_pin;
+#endif
+        tm1638_setup(&modules[i], transport, brightness);
+    }
+
+    // Framebuffers are all zero, the chips are unknown: one broadcast syncs them
+    tm1638_bus_display_clear(bus);
+    tm1638_bus_set_brightness(bus, brightness);
+    return true;
+}
+
+/**
+ * @brief Sets the brightness of every module with one broadcast command.
+ * @param bus Pointer to the bus object.
+ * @param brightness The brightness level, from 0 (dimmest) to 7 (brightest).
+ */
+void tm1638_bus_set_brightness(TM1638_Bus *bus, uint8_t brightness) {
+    if (brightness > 7) {
+        // Clamp brightness to the maximum value if out of range
+        brightness = 7;
+    }
+    uint8_t command = CMD_DISPLAY_CTRL | DISPLAY_ON_MASK | brightness;
+    for (uint8_t i = 0; i < bus->count; i++) {
+        bus->modules[i].brightness = brightness;
+    }
+    tm1638_bus_broadcast(bus, &command, 1);
+}
+
+/**
+ * @brief Clears every module with one broadcast burst.
+ * @param bus Pointer to the bus object.
+ */
+void tm1638_bus_display_clear(TM1638_Bus *bus) {
+    uint8_t frame[TM1638_MAX_FRAME_SIZE] = {0};
+    frame[0] = CMD_ADDRESS_SET;
+
+    tm1638_bus_broadcast(bus, &CMD_DATA_SET_AUTO_INC, 1);
+    tm1638_bus_broadcast(bus, frame, sizeof(frame));
+    for (uint8_t i = 0; i < bus->count; i++) {
+        memset(bus->modules[i].display_ram, 0, TM1638_RAM_SIZE);
+        bus->modules[i].dirty = 0;
+    }
+}
+
+/**
+ * @brief Flushes every module with pending framebuffer changes.
+ * @param bus Pointer to the bus object.
+ */
+void tm1638_bus_flush(TM1638_Bus *bus) {
+    for (uint8_t i = 0; i < bus->count; i++) {
+        tm1638_flush(&bus->modules[i]);
+    }
+}
+
+
+// --- Key Event Implementation ---
+
+/**
+ * @brief Initializes a key event engine for one module.
+ * @param kp Pointer to the keypad.
+ * @param tm The module to scan.
+ * @param board Key layout, or NULL for the 8 keys of tm1638_scan_buttons().
+ */
+void tm1638_keypad_init(TM1638_Keypad *kp, TM1638 *tm, const TM1638_Board *board) {
+    memset(kp, 0, sizeof(*kp));
+    kp->tm = tm;
+    kp->board = board;
+    kp->key_count = (board != NULL) ? board->key_count : 8;
+    kp->hold_ms = TM1638_HOLD_MS;
+    kp->idle_scan_ms = TM1638_IDLE_SCAN_MS;
+    kp->active_scan_ms = TM1638_ACTIVE_SCAN_MS;
+    memset(kp->debounce_ms, TM1638_DEBOUNCE_MS, sizeof(kp->debounce_ms));
+}
+
+/**
+ * @brief Sets the debounce time of one key.
+ * @param kp Pointer to the keypad.
+ * @param key Key number (1 = S1).
+ * @param debounce_ms Time the key must stay stable, in milliseconds.
+ */
+void tm1638_keypad_set_debounce(TM1638_Keypad *kp, uint8_t key, uint8_t debounce_ms) {
+    if (key < 1 || key > kp->key_count) {
+        return;
+    }
+    kp->debounce_ms[key - 1] = debounce_ms;
+}
+
+/**
+ * @brief Enables auto-repeat with acceleration for some keys.
+ * @param kp Pointer to the keypad.
+ * @param keys Keys to repeat, bit i for S(i+1).
+ * @param delay_ms Time from the press to the first repeat.
+ * @param start_ms First repeat interval.
+ * @param min_ms Shortest repeat interval.
+ */
+void tm1638_keypad_set_repeat(TM1638_Keypad *kp, uint32_t keys, uint16_t delay_ms,
+                              uint16_t start_ms, uint16_t min_ms) {
+    kp->repeat_delay_ms = delay_ms;
+    kp->repeat_start_ms = start_ms;
+    kp->repeat_min_ms = min_ms;
+    kp->repeat_keys = keys;
+}
+
+/**
+ * @brief Watches for a chord, i.e. several keys held down together.
+ * @param kp Pointer to the keypad.
+ * @param keys Keys of the chord, bit i for S(i+1).
+ * @return The chord number (1-TM1638_MAX_CHORDS), or 0 if the table is full.
+ */
+uint8_t tm1638_keypad_add_chord(TM1638_Keypad *kp, uint32_t keys) {
+    if (kp->chord_count == TM1638_MAX_CHORDS || keys == 0) {
+        return 0;
+    }
+    kp->chords[kp->chord_count] = keys;
+    return ++kp->chord_count;
+}
+
+/**
+ * @brief Scans the keys once and queues the resulting events.
+ * @param kp Pointer to the keypad.
+ * @param now_ms Current time in milliseconds.
+ */
+void tm1638_poll(TM1638_Keypad *kp, uint32_t now_ms) {
+    uint32_t keys;
+    if (kp->board != NULL) {
+        keys = tm1638_map_keys(kp->board, tm1638_scan_matrix(kp->tm));
+    } else {
+        keys = tm1638_scan_buttons(kp->tm);
+    }
+    tm1638_keypad_update(kp, keys, now_ms);
+}
+
+/**
+ * @brief Feeds an already scanned key state to the engine.
  *
- * This function maps ASCII characters to the common anode 7-segment display codes.
- * Segments are mapped as: bit 0=A, 1=B, 2=C, 3=D, 4=E, 5=F, 6=G.
+ * A key's new raw state is accepted once it has not changed for the key's
+ * debounce time. Only keys that are bouncing, pending or down are visited,
+ * and each visit and chord check is a fixed amount of work, so a poll is
+ * bounded by the key count and TM1638_MAX_CHORDS.
  *
- * @param c The character to convert.
- * @return The 8-bit segment code. Returns 0x00 (blank) for unsupported characters.
+ * @param kp Pointer to the keypad.
+ * @param keys Bit i set when key S(i+1) is down.
+ * @param now_ms Current time in milliseconds.
  */
-static uint8_t char_to_segment_code(char c) {
-    switch (c) {
-        // Digits
-        case '0': return 0x3f;
-        case '1': return 0x06;
-        case '2': return 0x5b;
-        case '3': return 0x4f;
-        case '4': return 0x66;
-        case '5': return 0x6d;
-        case '6': return 0x7d;
-        case '7': return 0x07;
-        case '8': return 0x7f;
-        case '9': return 0x6f;
-        // Letters (uppercase)
-        case 'A': return 0x77;
-        case 'B': return 0x7f; // Same as '8'
-        case 'C': return 0x39;
-        case 'D': return 0x3f;
-        case 'E': return 0x79;
-        case 'F': return 0x71;
-        case 'G': return 0x7d;
-        case 'H': return 0x76;
-        case 'I': return 0x06; // Same as '1'
-        case 'J': return 0x0e;
-        case 'L': return 0x38;
-        case 'O': return 0x3f; // Same as '0'
-        case 'P': return 0x73;
-        case 'S': return 0x6d; // Same as '5'
-        case 'U': return 0x3e;
-        // Letters (lowercase)
-        case 'a': return 0x5f;
-        case 'b': return 0x7c;
-        case 'c': return 0x58;
-        case 'd': return 0x5e;
-        case 'f': return 0x71;
-        case 'g': return 0x6f;
-        case 'h': return 0x74;
-        case 'i': return 0x04;
-        case 'n': return 0x54;
-        case 'o': return 0x5c;
-        case 'r': return 0x50;
-        case 't': return 0x78;
-        case 'u': return 0x1c;
-        case 'y': return 0x6e;
-        // Symbols
-        case ' ': return 0x00;
-        case '_': return 0x08;
-        case '-': return 0x40;
-        default:  return 0x00; // Blank for unsupported characters
-    }
-}
\ No newline at end of file
+void tm1638_keypad_update(TM1638_Keypad *kp, uint32_t keys, uint32_t now_ms) {
+    uint32_t edges = keys ^ kp->raw;
+    uint32_t active;
+
+    kp->raw = keys;
+    active = edges | (keys ^ kp->stable) | kp->stable;
+
+    for (uint8_t i = 0; i < kp->key_count && active != 0; i++, active >>= 1) {
+        uint32_t bit = 1UL << i;
+        if ((active & 1U) == 0) {
+            continue;
+        }
+        if (edges & bit) {
+            kp->changed_ms[i] = now_ms;
+        }
+        if (((keys ^ kp->stable) & bit) && (uint32_t)(now_ms - kp->changed_ms[i]) >= kp->debounce_ms[i]) {
+            kp->stable ^= bit;
+            if (keys & bit) {
+                kp->pressed_ms[i] = kp->changed_ms[i];
+                kp->next_repeat_ms[i] = kp->changed_ms[i] + kp->repeat_delay_ms;
+                kp->repeat_interval_ms[i] = kp->repeat_start_ms;
+                tm1638_queue_event(kp, i + 1, TM1638_KEY_PRESS, kp->changed_ms[i]);
+            } else {
+                kp->held &= ~bit;
+                tm1638_queue_event(kp, i + 1, TM1638_KEY_RELEASE, kp->changed_ms[i]);
+            }
+        }
+        if ((kp->stable & ~kp->held & bit) && kp->hold_ms != 0
+                && (uint32_t)(now_ms - kp->pressed_ms[i]) >= kp->hold_ms) {
+            kp->held |= bit;
+            tm1638_queue_event(kp, i + 1, TM1638_KEY_HOLD, now_ms);
+        }
+        // Not while a release is being debounced, or the repeat would be stamped after it
+        if ((kp->stable & keys & kp->repeat_keys & bit)
+                && (int32_t)(now_ms - kp->next_repeat_ms[i]) >= 0) {
+            uint16_t interval = kp->repeat_interval_ms[i];
+            tm1638_queue_event(kp, i + 1, TM1638_KEY_REPEAT, now_ms);
+            // Rescheduled from now, so a late poll does not cause a burst of repeats
+            kp->next_repeat_ms[i] = now_ms + interval;
+            interval -= interval / 8;
+            kp->repeat_interval_ms[i] = (interval > kp->repeat_min_ms) ? interval : kp->repeat_min_ms;
+        }
+    }
+
+    for (uint8_t c = 0; c < kp->chord_count; c++) {
+        uint8_t bit = (uint8_t)(1U << c);
+        if ((kp->stable & kp->chords[c]) != kp->chords[c]) {
+            kp->chords_down &= (uint8_t)~bit;
+        } else if ((kp->chords_down & bit) == 0) {
+            kp->chords_down |= bit;
+            tm1638_queue_event(kp, c + 1, TM1638_KEY_CHORD, now_ms);
+        }
+    }
+}
+
+#ifndef TM1638_NO_HAL
+/**
+ * @brief Waits for a key event with the core asleep between scans.
+ * @param kp Pointer to the keypad.
+ * @param event Receives the event.
+ * @param timeout_ms Longest wait in milliseconds, HAL_MAX_DELAY to wait forever.
+ * @return true if an event was returned, false on timeout.
+ */
+bool tm1638_wait_event(TM1638_Keypad *kp, TM1638_KeyEvent *event, uint32_t timeout_ms) {
+    uint32_t start = HAL_GetTick();
+    uint32_t now = start;
+    uint32_t cycles;
+    bool found;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    cycles = DWT->CYCCNT;
+
+    for (;;) {
+        uint32_t interval;
+        uint32_t count;
+
+        tm1638_poll(kp, now);
+        if (kp->raw != 0) {
+            kp->activity_ms = now;
+        }
+        found = tm1638_get_event(kp, event);
+        if (found || (timeout_ms != HAL_MAX_DELAY && (uint32_t)(now - start) >= timeout_ms)) {
+            break;
+        }
+
+        interval = ((uint32_t)(now - kp->activity_ms) < TM1638_ACTIVE_HOLDOFF_MS)
+                 ? kp->active_scan_ms : kp->idle_scan_ms;
+        if (timeout_ms != HAL_MAX_DELAY && interval > timeout_ms - (now - start)) {
+            interval = timeout_ms - (now - start);
+        }
+        tm1638_sleep_until(now + interval);
+        now = HAL_GetTick();
+
+        // Accumulated per scan so the 32-bit counter cannot wrap in between
+        count = DWT->CYCCNT;
+        kp->awake_cycles += (uint32_t)(count - cycles);
+        cycles = count;
+    }
+
+    kp->awake_cycles += (uint32_t)(DWT->CYCCNT - cycles);
+    kp->wait_ms += now - start;
+    return found;
+}
+
+/**
+ * @brief Share of the time spent in tm1638_wait_event() the core was awake.
+ * @param kp Pointer to the keypad.
+ * @return The duty cycle in per mille (0-1000).
+ */
+uint16_t tm1638_wait_duty_permille(const TM1638_Keypad *kp) {
+    uint64_t total = (uint64_t)kp->wait_ms * (SystemCoreClock / 1000U);
+    uint64_t duty;
+    if (total == 0) {
+        return 0;
+    }
+    duty = kp->awake_cycles * 1000U / total;
+    return (uint16_t)((duty > 1000U) ? 1000U : duty);
+}
+#endif /* TM1638_NO_HAL */
+
+/**
+ * @brief Takes the oldest event from the queue.
+ *
+ * Consumer side of the lock-free ring: safe against a concurrent
+ * tm1638_poll() in an interrupt or another task, as long as each side has
+ * a single caller.
+ *
+ * @param kp Pointer to the keypad.
+ * @param event Receives the event.
+ * @return true if an event was returned, false if the queue is empty.
+ */
+bool tm1638_get_event(TM1638_Keypad *kp, TM1638_KeyEvent *event) {
+    uint8_t tail = kp->tail; // Only written here
+    // Acquire: the slot contents written before head was published are visible
+    uint8_t head = __atomic_load_n(&kp->head, __ATOMIC_ACQUIRE);
+
+    if (head == tail) {
+        return false;
+    }
+    *event = kp->queue[tail & (TM1638_KEY_QUEUE_SIZE - 1)];
+    // Release: the slot is read before the producer may reuse it
+    __atomic_store_n(&kp->tail, (uint8_t)(tail + 1), __ATOMIC_RELEASE);
+    return true;
+}
+
+// --- Private Helper Function Implementation ---
+
+/**
+ * @brief Binds a handle to its transport and resets its framebuffer, without bus traffic.
+ * @param tm Pointer to the TM1638 handle.
+ * @param transport The bus implementation to use.
+ * @param brightness Initial brightness level (0-7).
+ */
+static void tm1638_setup(TM1638 *tm, const TM1638_Transport *transport, uint8_t brightness) {
+    tm->transport = transport;
+    tm->brightness = brightness & DISPLAY_BRIGHTNESS_MASK; // Ensure brightness is within 0-7
+    if (transport->init != NULL) {
+        transport->init(tm);
+    }
+    memset(tm->display_ram, 0, sizeof(tm->display_ram));
+    tm->dirty = 0;
+#ifdef TM1638_ENABLE_STATS
+#if !defined(TM1638_NO_HAL)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    tm1638_reset_stats(tm);
+#endif
+}
+
+/**
+ * @brief Sends one transaction to every module of a bus at once.
+ *
+ * All STB lines are pulled low before the bytes are clocked out on the
+ * shared CLK/DIO lines, so each chip receives the same frame.
+ *
+ * @param bus Pointer to the bus object.
+ * @param frame Bytes to send.
+ * @param len Number of bytes in the frame.
+ */
+static void tm1638_bus_broadcast(TM1638_Bus *bus, const uint8_t *frame, uint8_t len) {
+    if (bus->count == 0) {
+        return;
+    }
+    for (uint8_t i = 0; i < bus->count; i++) {
+        bus->modules[i].transport->begin(&bus->modules[i]);
+    }
+    bus->modules[0].transport->write(&bus->modules[0], frame, len);
+    for (uint8_t i = 0; i < bus->count; i++) {
+        bus->modules[i].transport->end(&bus->modules[i]);
+    }
+#ifdef TM1638_ENABLE_STATS
+    tm1638_stats_bus(&bus->modules[0], len, 0);
+#endif
+}
+
+/**
+ * @brief Stores a value in the shadow framebuffer and marks it dirty if it changed.
+ * @param tm Pointer to the TM1638 handle.
+ * @param address The register address (0-15).
+ * @param value The value to store.
+ */
+static void tm1638_ram_write(TM1638 *tm, uint8_t address, uint8_t value) {
+    if (tm->display_ram[address] != value) {
+        tm->display_ram[address] = value;
+        tm->dirty |= (uint16_t)(1U << address);
+    }
+}
+
+/**
+ * @brief Reads the 4 bytes of key scan data as one word, byte 0 lowest.
+ * @param tm Pointer to the TM1638 handle.
+ * @return The raw key matrix bitmap.
+ */
+static uint32_t tm1638_read_keys(TM1638 *tm) {
+    uint8_t key_bytes[4];
+#ifdef TM1638_ENABLE_STATS
+    uint32_t start = TM1638_CYCLES();
+#endif
+
+    tm->transport->begin(tm);
+    tm->transport->write(tm, &CMD_DATA_READ, 1);
+    tm->transport->read(tm, key_bytes, sizeof(key_bytes));
+    tm->transport->end(tm);
+
+#ifdef TM1638_ENABLE_STATS
+    tm1638_stats_bus(tm, 1, sizeof(key_bytes));
+    tm->stats.scans++;
+    tm1638_stats_op(&tm->stats.scan, start);
+#endif
+
+    return (uint32_t)key_bytes[0]
+         | ((uint32_t)key_bytes[1] << 8)
+         | ((uint32_t)key_bytes[2] << 16)
+         | ((uint32_t)key_bytes[3] << 24);
+}
+
+/**
+ * @brief Appends an event to a keypad's ring, or counts it as dropped if full.
+ *
+ * Producer side of the lock-free ring, see tm1638_get_event().
+ * @param kp Pointer to the keypad.
+ * @param key Key number (1 = S1).
+ * @param type Kind of event.
+ * @param time_ms Event timestamp.
+ */
+static void tm1638_queue_event(TM1638_Keypad *kp, uint8_t key, TM1638_KeyEventType type, uint32_t time_ms) {
+    uint8_t head = kp->head; // Only written here
+    uint8_t tail = __atomic_load_n(&kp->tail, __ATOMIC_ACQUIRE);
+    TM1638_KeyEvent *event;
+
+    if ((uint8_t)(head - tail) == TM1638_KEY_QUEUE_SIZE) {
+        kp->dropped++;
+        return;
+    }
+    event = &kp->queue[head & (TM1638_KEY_QUEUE_SIZE - 1)];
+    event->key = key;
+    event->type = type;
+    event->time_ms = time_ms;
+    // Release: the event is complete before the consumer can see it
+    __atomic_store_n(&kp->head, (uint8_t)(head + 1), __ATOMIC_RELEASE);
+}
+
+#ifndef TM1638_NO_HAL
+/**
+ * @brief Sleeps the core (WFI) until the HAL tick reaches the given value.
+ *
+ * Every interrupt wakes the core, at the latest the 1 ms HAL tick, so the
+ * tick is checked again after each wake-up.
+ *
+ * @param tick HAL_GetTick() value to wait for.
+ */
+static void tm1638_sleep_until(uint32_t tick) {
+    while ((int32_t)(HAL_GetTick() - tick) < 0) {
+        __WFI();
+    }
+}
+
+/**
+ * @brief Converts a time into core cycles, rounded up (at most 65535).
+ * @param ns Time in nanoseconds.
+ * @return The number of SystemCoreClock cycles.
+ */
+static uint16_t tm1638_ns_to_cycles(uint32_t ns) {
+    uint64_t cycles = ((uint64_t)ns * SystemCoreClock + 999999999U) / 1000000000U;
+    return (uint16_t)((cycles > 0xFFFFU) ? 0xFFFFU : cycles);
+}
+
+/**
+ * @brief Checks that key reads at the current timing are valid and stable.
+ *
+ * Each read is a full key scan: STB low, the read command clocked out at the
+ * timing under test, Twait (in transport->read), then the 32 key data clocks
+ * at the timing under test, and STB high. Only this read path is verified:
+ * the display registers cannot be read back, so writes are not checked.
+ *
+ * The reserved bits 3 and 7 of every key byte always read 0. A byte of 0xFF
+ * means the chip never drove DIO, i.e. it did not take the read command,
+ * and it fails the same test. Bits that differ between reads show data
+ * sampled too early or too late.
+ *
+ * @param tm Pointer to the TM1638 handle.
+ * @return true if TM1638_CAL_READS reads were valid and identical.
+ */
+static bool tm1638_timing_ok(TM1638 *tm) {
+    uint8_t first[4];
+    uint8_t bytes[4];
+
+    for (uint8_t r = 0; r < TM1638_CAL_READS; r++) {
+        tm->transport->begin(tm);
+        tm->transport->write(tm, &CMD_DATA_READ, 1);
+        tm->transport->read(tm, bytes, sizeof(bytes));
+        tm->transport->end(tm);
+#ifdef TM1638_ENABLE_STATS
+        tm1638_stats_bus(tm, 1, sizeof(bytes));
+#endif
+
+        for (uint8_t b = 0; b < sizeof(bytes); b++) {
+            if (bytes[b] & 0x88) {
+                return false;
+            }
+        }
+        if (r == 0) {
+            memcpy(first, bytes, sizeof(first));
+        } else if (memcmp(first, bytes, sizeof(first)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+/**
+ * @brief Converts a character to its 7-segment display hexadecimal code.
+ *
+ * This function maps ASCII characters to the common anode 7-segment display codes.
+ * Segments are mapped as: bit 0=A, 1=B, 2=C, 3=D, 4=E, 5=F, 6=G.
+ *
+ * @param c The character to convert.
+ * @return The 8-bit segment code. Returns 0x00 (blank) for unsupported characters.
+ */
+static uint8_t char_to_segment_code(char c) {
+    uint8_t index = (uint8_t)c;
+    return (index < sizeof(SEGMENT_FONT)) ? SEGMENT_FONT[index] : 0x00;
+}
+
+#ifdef TM1638_ENABLE_STATS
+/**
+ * @brief Records the duration of an operation that started at the given cycle count.
+ * @param op Statistics of the operation.
+ * @param start TM1638_CYCLES() value at the start of the operation.
+ */
+static void tm1638_stats_op(TM1638_OpStats *op, uint32_t start) {
+    uint32_t cycles = (uint32_t)(TM1638_CYCLES() - start);
+    op->count++;
+    op->total_cycles += cycles;
+    if (cycles < op->min_cycles) {
+        op->min_cycles = cycles;
+    }
+    if (cycles > op->max_cycles) {
+        op->max_cycles = cycles;
+    }
+}
+
+/**
+ * @brief Counts one bus transaction.
+ * @param tm Pointer to the TM1638 handle.
+ * @param sent Bytes clocked out.
+ * @param received Bytes clocked in.
+ */
+static void tm1638_stats_bus(TM1638 *tm, uint32_t sent, uint32_t received) {
+    tm->stats.transactions++;
+    tm->stats.bytes_sent += sent;
+    tm->stats.bytes_received += received;
+}
+#endif
+
+#ifndef TM1638_NO_HAL
+
+// --- STM32 HAL Transports ---
+
+// Low-level GPIO pin control functions (HAL backend)
+static void tm1638_sdo_high(TM1638 *tm);
+static void tm1638_sdo_low(TM1638 *tm);
+static void tm1638_stb_high(TM1638 *tm);
+static void tm1638_stb_low(TM1638 *tm);
+static void tm1638_clk_high(TM1638 *tm);
+static void tm1638_clk_low(TM1638 *tm);
+static void tm1638_send_data(TM1638 *tm, uint8_t data);
+
+// DIO direction switching shared by the bit-banged transports
+static void tm1638_dio_init(TM1638 *tm);
+static void tm1638_dio_input(TM1638 *tm);
+static void tm1638_dio_output(TM1638 *tm);
+static void tm1638_delay_cycles(uint32_t cycles);
+static void tm1638_twait_init(TM1638 *tm);
+
+static void tm1638_stb_high(TM1638 *tm) {
+    HAL_GPIO_WritePin(tm->stb_port, tm->stb_pin, GPIO_PIN_SET);
+}
+static void tm1638_stb_low(TM1638 *tm) {
+    HAL_GPIO_WritePin(tm->stb_port, tm->stb_pin, GPIO_PIN_RESET);
+}
+static void tm1638_sdo_high(TM1638 *tm) {
+    HAL_GPIO_WritePin(tm->dio_port, tm->dio_pin, GPIO_PIN_SET);
+}
+static void tm1638_sdo_low(TM1638 *tm) {
+    HAL_GPIO_WritePin(tm->dio_port, tm->dio_pin, GPIO_PIN_RESET);
+}
+static void tm1638_clk_high(TM1638 *tm) {
+    HAL_GPIO_WritePin(tm->clk_port, tm->clk_pin, GPIO_PIN_SET);
+}
+static void tm1638_clk_low(TM1638 *tm) {
+    HAL_GPIO_WritePin(tm->clk_port, tm->clk_pin, GPIO_PIN_RESET);
+}
+
+/**
+ * @brief Sends a byte of data to the TM1638, LSB first.
+ * @param tm Pointer to the TM1638 handle.
+ * @param data The byte of data to send.
+ */
+static void tm1638_send_data(TM1638 *tm, uint8_t data) {
+    for (uint8_t i = 0; i < 8; i++) {
+        tm1638_clk_low(tm);
+        // Set data pin high or low based on the current bit (LSB first)
+        if (data & 0x01) {
+            tm1638_sdo_high(tm);
+        } else {
+            tm1638_sdo_low(tm);
+        }
+        // Right-shift data to process the next bit in the next iteration
+        data >>= 1;
+        tm1638_delay_cycles(tm->clk_low_cycles);
+        tm1638_clk_high(tm);
+        tm1638_delay_cycles(tm->clk_high_cycles);
+    }
+}
+
+/**
+ * @brief Busy-waits for a number of core cycles on the DWT cycle counter.
+ * @param cycles Cycles to wait (0 returns at once).
+ */
+static void tm1638_delay_cycles(uint32_t cycles) {
+    if (cycles == 0) {
+        return;
+    }
+    uint32_t start = DWT->CYCCNT;
+    while ((uint32_t)(DWT->CYCCNT - start) < cycles) {
+    }
+}
+
+/**
+ * @brief Precomputes Twait, the wait between the read command and the first key data clock.
+ *
+ * The chip needs TM1638_TWAIT_NS to fetch the key data, and a read clocked
+ * sooner shifts out garbage on a fast core.
+ *
+ * @param tm Pointer to the TM1638 handle.
+ */
+static void tm1638_twait_init(TM1638 *tm) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    tm->twait_cycles = tm1638_ns_to_cycles(TM1638_TWAIT_NS);
+}
+
+/**
+ * @brief Prepares the DIO pin for fast direction changes.
+ *
+ * Enables the pull-up once (harmless while the pin drives the line) and
+ * precomputes the MODER field of the pin, so key reads only flip MODER
+ * instead of going through HAL_GPIO_Init() twice per scan.
+ *
+ * If DIO was configured as an open-drain output, it is left in that mode for
+ * good: the TM1638 can pull the line low by itself, so reads only need the
+ * pin released high and the direction never changes.
+ *
+ * @param tm Pointer to the TM1638 handle.
+ */
+static void tm1638_dio_init(TM1638 *tm) {
+    uint32_t pos = 0;
+    while (((uint32_t)tm->dio_pin >> pos) > 1U) {
+        pos++;
+    }
+    tm->dio_moder_mask = 0x3UL << (2 * pos);
+    tm->dio_moder_output = 0x1UL << (2 * pos); // General purpose output mode
+    tm->dio_open_drain = (tm->dio_port->OTYPER & tm->dio_pin) != 0;
+
+    tm1638_twait_init(tm);
+
+    // Use pull-up to ensure stable line while the TM1638 is not driving it
+    tm->dio_port->PUPDR = (tm->dio_port->PUPDR & ~tm->dio_moder_mask) | (0x1UL << (2 * pos));
+}
+
+/**
+ * @brief Temporarily sets the DIO pin as input to read data from the TM1638.
+ *
+ * Returns after Twait, so the caller can start clocking key data right away.
+ *
+ * @param tm Pointer to the TM1638 handle.
+ */
+static void tm1638_dio_input(TM1638 *tm) {
+    if (tm->dio_open_drain) {
+        // Release the line; the last command bit may have left it low
+        tm->dio_port->BSRR = tm->dio_pin;
+    } else {
+        tm->dio_port->MODER &= ~tm->dio_moder_mask; // Input mode is 0b00
+    }
+    tm1638_delay_cycles(tm->twait_cycles);
+}
+
+/**
+ * @brief Restores the DIO pin to output mode.
+ * @param tm Pointer to the TM1638 handle.
+ */
+static void tm1638_dio_output(TM1638 *tm) {
+    if (tm->dio_open_drain) {
+        return; // Never left output mode
+    }
+    tm->dio_port->MODER = (tm->dio_port->MODER & ~tm->dio_moder_mask) | tm->dio_moder_output;
+}
+
+// HAL_GPIO_WritePin / HAL_GPIO_ReadPin transport
+
+static void tm1638_hal_begin(TM1638 *tm) {
+    tm1638_stb_low(tm);
+}
+
+static void tm1638_hal_end(TM1638 *tm) {
+    tm1638_stb_high(tm);
+}
+
+static void tm1638_hal_write(TM1638 *tm, const uint8_t *data, uint8_t len) {
+    for (uint8_t n = 0; n < len; n++) {
+        tm1638_send_data(tm, data[n]);
+    }
+}
+
+static void tm1638_hal_read(TM1638 *tm, uint8_t *data, uint8_t len) {
+    tm1638_dio_input(tm);
+    for (uint8_t n = 0; n < len; n++) {
+        uint8_t byte = 0;
+        for (uint8_t i = 0; i < 8; i++) {
+            tm1638_clk_low(tm);
+            tm1638_delay_cycles(tm->clk_low_cycles); // Let the chip's data settle
+            if (HAL_GPIO_ReadPin(tm->dio_port, tm->dio_pin) == GPIO_PIN_SET) {
+                byte |= (uint8_t)(1U << i);
+            }
+            tm1638_clk_high(tm);
+            tm1638_delay_cycles(tm->clk_high_cycles);
+        }
+        data[n] = byte;
+    }
+    tm1638_dio_output(tm);
+}
+
+const TM1638_Transport tm1638_transport_hal = {
+    .init = tm1638_dio_init,
+    .begin = tm1638_hal_begin,
+    .end = tm1638_hal_end,
+    .write = tm1638_hal_write,
+    .read = tm1638_hal_read,
+    .send_frame = NULL,
+    .stb_cycle_cost = TM1638_STB_CYCLE_COST,
+};
+
+// Direct BSRR / IDR register transport
+
+/**
+ * @brief Precomputes the BSRR words so every pin edge is a single store,
+ *        and the DIO direction masks.
+ * @param tm Pointer to the TM1638 handle.
+ */
+static void tm1638_reg_init(TM1638 *tm) {
+    tm1638_dio_init(tm);
+    tm->clk_set = tm->clk_pin;
+    tm->clk_reset = (uint32_t)tm->clk_pin << 16;
+    tm->dio_set = tm->dio_pin;
+    tm->dio_reset = (uint32_t)tm->dio_pin << 16;
+    tm->stb_set = tm->stb_pin;
+    tm->stb_reset = (uint32_t)tm->stb_pin << 16;
+}
+
+// A single store to BSRR sets or resets a pin atomically, no read-modify-write needed.
+static void tm1638_reg_begin(TM1638 *tm) {
+    tm->stb_port->BSRR = tm->stb_reset;
+}
+
+static void tm1638_reg_end(TM1638 *tm) {
+    tm->stb_port->BSRR = tm->stb_set;
+}
+
+/**
+ * @brief Register transport write with the CLK times of tm1638_set_timing().
+ * @param tm Pointer to the TM1638 handle.
+ * @param data Bytes to send.
+ * @param len Number of bytes.
+ */
+static void tm1638_reg_write_timed(TM1638 *tm, const uint8_t *data, uint8_t len) {
+    for (uint8_t n = 0; n < len; n++) {
+        uint8_t byte = data[n];
+        for (uint8_t i = 0; i < 8; i++) {
+            tm->clk_port->BSRR = tm->clk_reset;
+            tm->dio_port->BSRR = (byte & 0x01) ? tm->dio_set : tm->dio_reset;
+            byte >>= 1;
+            tm1638_delay_cycles(tm->clk_low_cycles);
+            tm->clk_port->BSRR = tm->clk_set;
+            tm1638_delay_cycles(tm->clk_high_cycles);
+        }
+    }
+}
+
+#ifdef TM1638_USE_TX_TABLE
+/*
+ * For every byte, the left shift turning dio_pin into the BSRR word of each
+ * bit (LSB first): 0 sets DIO, 16 resets it.
+ */
+#define TX_BIT(b, i) ((((b) >> (i)) & 1U) ? 0 : 16)
+#define TX_ROW(b) { TX_BIT(b, 0), TX_BIT(b, 1), TX_BIT(b, 2), TX_BIT(b, 3), \
+                    TX_BIT(b, 4), TX_BIT(b, 5), TX_BIT(b, 6), TX_BIT(b, 7) }
+#define TX_ROW4(b) TX_ROW(b), TX_ROW((b) + 1), TX_ROW((b) + 2), TX_ROW((b) + 3)
+#define TX_ROW16(b) TX_ROW4(b), TX_ROW4((b) + 4), TX_ROW4((b) + 8), TX_ROW4((b) + 12)
+#define TX_ROW64(b) TX_ROW16(b), TX_ROW16((b) + 16), TX_ROW16((b) + 32), TX_ROW16((b) + 48)
+
+static const uint8_t TX_SHIFT[256][8] = {
+    TX_ROW64(0), TX_ROW64(64), TX_ROW64(128), TX_ROW64(192)
+};
+
+#undef TX_BIT
+#undef TX_ROW
+#undef TX_ROW4
+#undef TX_ROW16
+#undef TX_ROW64
+
+static void tm1638_reg_write(TM1638 *tm, const uint8_t *data, uint8_t len) {
+    GPIO_TypeDef *clk_port = tm->clk_port;
+    GPIO_TypeDef *dio_port = tm->dio_port;
+    const uint32_t clk_set = tm->clk_set;
+    const uint32_t clk_reset = tm->clk_reset;
+    const uint32_t dio_pin = tm->dio_pin;
+
+    if ((tm->clk_low_cycles | tm->clk_high_cycles) != 0) {
+        tm1638_reg_write_timed(tm, data, len);
+        return;
+    }
+    for (uint8_t n = 0; n < len; n++) {
+        const uint8_t *shift = TX_SHIFT[data[n]];
+        clk_port->BSRR = clk_reset; dio_port->BSRR = dio_pin << shift[0]; clk_port->BSRR = clk_set;
+        clk_port->BSRR = clk_reset; dio_port->BSRR = dio_pin << shift[1]; clk_port->BSRR = clk_set;
+        clk_port->BSRR = clk_reset; dio_port->BSRR = dio_pin << shift[2]; clk_port->BSRR = clk_set;
+        clk_port->BSRR = clk_reset; dio_port->BSRR = dio_pin << shift[3]; clk_port->BSRR = clk_set;
+        clk_port->BSRR = clk_reset; dio_port->BSRR = dio_pin << shift[4]; clk_port->BSRR = clk_set;
+        clk_port->BSRR = clk_reset; dio_port->BSRR = dio_pin << shift[5]; clk_port->BSRR = clk_set;
+        clk_port->BSRR = clk_reset; dio_port->BSRR = dio_pin << shift[6]; clk_port->BSRR = clk_set;
+        clk_port->BSRR = clk_reset; dio_port->BSRR = dio_pin << shift[7]; clk_port->BSRR = clk_set;
+    }
+}
+#else
+static void tm1638_reg_write(TM1638 *tm, const uint8_t *data, uint8_t len) {
+    if ((tm->clk_low_cycles | tm->clk_high_cycles) != 0) {
+        tm1638_reg_write_timed(tm, data, len);
+        return;
+    }
+    for (uint8_t n = 0; n < len; n++) {
+        uint8_t byte = data[n];
+        for (uint8_t i = 0; i < 8; i++) {
+            tm->clk_port->BSRR = tm->clk_reset;
+            tm->dio_port->BSRR = (byte & 0x01) ? tm->dio_set : tm->dio_reset;
+            byte >>= 1;
+            tm->clk_port->BSRR = tm->clk_set;
+        }
+    }
+}
+#endif /* TM1638_USE_TX_TABLE */
+
+static void tm1638_reg_read(TM1638 *tm, uint8_t *data, uint8_t len) {
+    tm1638_dio_input(tm);
+    for (uint8_t n = 0; n < len; n++) {
+        uint8_t byte = 0;
+        for (uint8_t i = 0; i < 8; i++) {
+            tm->clk_port->BSRR = tm->clk_reset;
+            tm1638_delay_cycles(tm->clk_low_cycles);
+            if (tm->dio_port->IDR & tm->dio_pin) {
+                byte |= (uint8_t)(1U << i);
+            }
+            tm->clk_port->BSRR = tm->clk_set;
+            tm1638_delay_cycles(tm->clk_high_cycles);
+        }
+        data[n] = byte;
+    }
+    tm1638_dio_output(tm);
+}
+
+const TM1638_Transport tm1638_transport_reg = {
+    .init = tm1638_reg_init,
+    .begin = tm1638_reg_begin,
+    .end = tm1638_reg_end,
+    .write = tm1638_reg_write,
+    .read = tm1638_reg_read,
+    .send_frame = NULL,
+    .stb_cycle_cost = TM1638_STB_CYCLE_COST,
+};
+
+#ifdef HAL_SPI_MODULE_ENABLED
+
+// Half-duplex SPI transport, frames sent by DMA
+
+static void tm1638_spi_init(TM1638 *tm) {
+    tm->tx_busy = false;
+    tm1638_twait_init(tm);
+    // The SPI pin setup leaves MOSI floating while the chip drives key data
+    if (tm->dio_port != NULL) {
+        tm1638_dio_init(tm);
+    }
+}
+
+static void tm1638_spi_begin(TM1638 *tm) {
+    // A DMA frame may still be on the wire; STB is released by its completion
+    while (tm->tx_busy) {
+    }
+    tm1638_stb_low(tm);
+}
+
+static void tm1638_spi_end(TM1638 *tm) {
+    tm1638_stb_high(tm);
+}
+
+/**
+ * @brief Sends bytes through the SPI peripheral.
+ *
+ * The SPI must be configured LSB first, so the bytes go out in the same
+ * order as with the bit-banged transports.
+ */
+static void tm1638_spi_write(TM1638 *tm, const uint8_t *data, uint8_t len) {
+    if (HAL_SPI_Transmit(tm->hspi, (uint8_t *)data, len, TM1638_SPI_TIMEOUT_MS) != HAL_OK) {
+        // The bytes are lost; reset the peripheral so the next transaction goes out
+        HAL_SPI_Abort(tm->hspi);
+    }
+}
+
+/**
+ * @brief Reads bytes with an SPI receive.
+ *
+ * In bidirectional one-line mode the HAL turns the data line around by
+ * itself, so no GPIO reconfiguration is needed.
+ */
+static void tm1638_spi_read(TM1638 *tm, uint8_t *data, uint8_t len) {
+    tm1638_delay_cycles(tm->twait_cycles); // The receive clocks right away
+    if (HAL_SPI_Receive(tm->hspi, data, len, TM1638_SPI_TIMEOUT_MS) != HAL_OK) {
+        memset(data, 0, len); // Report "no keys" rather than garbage
+    }
+}
+
+/**
+ * @brief Sends a complete STB-framed transaction by DMA.
+ *
+ * The frame is copied into the handle so the caller's buffer can be reused
+ * right away. STB is raised by tm1638_spi_tx_complete() once the transfer
+ * is done, so this returns while the bytes are still being shifted out.
+ */
+static void tm1638_spi_send_frame(TM1638 *tm, const uint8_t *frame, uint8_t len) {
+    tm1638_spi_begin(tm);
+    memcpy(tm->spi_frame, frame, len);
+    tm->tx_busy = true;
+    if (HAL_SPI_Transmit_DMA(tm->hspi, tm->spi_frame, len) != HAL_OK) {
+        // Nothing will complete, so release the bus now
+        tm->tx_busy = false;
+        tm1638_spi_end(tm);
+    }
+}
+
+/**
+ * @brief Ends the DMA frame started by a flush.
+ * @param tm Pointer to the TM1638 handle.
+ */
+void tm1638_spi_tx_complete(TM1638 *tm) {
+    if (tm->tx_busy) {
+        tm1638_spi_end(tm);
+        tm->tx_busy = false;
+    }
+}
+
+const TM1638_Transport tm1638_transport_spi = {
+    .init = tm1638_spi_init,
+    .begin = tm1638_spi_begin,
+    .end = tm1638_spi_end,
+    .write = tm1638_spi_write,
+    .read = tm1638_spi_read,
+    .send_frame = tm1638_spi_send_frame,
+    // Every transaction is a separate DMA request, so favour long bursts
+    .stb_cycle_cost = 64,
+};
+
+#endif /* HAL_SPI_MODULE_ENABLED */
+
+#ifdef TM1638_ENABLE_TIM_DMA
+
+// Timer-paced DMA waveform transport (register transport for everything but frames)
+
+static void tm1638_wave_dma_complete(DMA_HandleTypeDef *hdma);
+static void tm1638_wave_dma_error(DMA_HandleTypeDef *hdma);
+
+static void tm1638_wave_init(TM1638 *tm) {
+    tm1638_reg_init(tm);
+    tm->tx_busy = false;
+    // The driver starts the stream itself, so it owns the stream's callbacks
+    tm->hdma->Parent = tm;
+    tm->hdma->XferCpltCallback = tm1638_wave_dma_complete;
+    tm->hdma->XferErrorCallback = tm1638_wave_dma_error;
+    tm->hdma->XferAbortCallback = tm1638_wave_dma_error;
+}
+
+static void tm1638_wave_begin(TM1638 *tm) {
+    // The previous waveform must have finished before the bus is reused
+    while (tm->tx_busy) {
+    }
+    tm1638_reg_begin(tm);
+}
+
+/**
+ * @brief Sends a complete STB-framed transaction as a DMA-played waveform.
+ *
+ * The frame is turned into the exact sequence of BSRR words the CPU loop
+ * would write: STB low, then for each bit CLK low together with the data
+ * level followed by CLK high, and finally STB high. Each timer update event
+ * moves one word into BSRR, so no CPU time is spent per bit.
+ */
+static void tm1638_wave_send_frame(TM1638 *tm, const uint8_t *frame, uint8_t len) {
+    uint32_t *word;
+
+    // One BSRR can only drive all three lines when they share a port
+    if (tm->clk_port != tm->dio_port || tm->dio_port != tm->stb_port) {
+        tm1638_wave_begin(tm);
+        tm1638_reg_write(tm, frame, len);
+        tm1638_reg_end(tm);
+        return;
+    }
+
+    while (tm->tx_busy) {
+    }
+
+    word = tm->wave;
+    *word++ = tm->stb_reset;
+    for (uint8_t n = 0; n < len; n++) {
+        uint8_t data = frame[n];
+        for (uint8_t i = 0; i < 8; i++) {
+            *word++ = tm->clk_reset | ((data & 0x01) ? tm->dio_set : tm->dio_reset);
+            *word++ = tm->clk_set;
+            data >>= 1;
+        }
+    }
+    *word++ = tm->stb_set;
+
+    tm->tx_busy = true;
+    __HAL_TIM_ENABLE_DMA(tm->htim, TIM_DMA_UPDATE);
+    if (HAL_DMA_Start_IT(tm->hdma, (uint32_t)(uintptr_t)tm->wave, (uint32_t)(uintptr_t)&tm->stb_port->BSRR,
+                         (uint32_t)(word - tm->wave)) != HAL_OK) {
+        // DMA unavailable: fall back to the CPU loop so the frame is not lost
+        __HAL_TIM_DISABLE_DMA(tm->htim, TIM_DMA_UPDATE);
+        tm->tx_busy = false;
+        tm1638_reg_begin(tm);
+        tm1638_reg_write(tm, frame, len);
+        tm1638_reg_end(tm);
+        return;
+    }
+    HAL_TIM_Base_Start(tm->htim);
+}
+
+/**
+ * @brief DMA transfer-complete callback: stops the pacing timer and frees the bus.
+ *
+ * STB has already been raised by the last word of the waveform.
+ *
+ * @param hdma DMA handle whose Parent points to the TM1638 handle.
+ */
+static void tm1638_wave_dma_complete(DMA_HandleTypeDef *hdma) {
+    TM1638 *tm = (TM1638 *)hdma->Parent;
+
+    HAL_TIM_Base_Stop(tm->htim);
+    __HAL_TIM_DISABLE_DMA(tm->htim, TIM_DMA_UPDATE);
+    tm->tx_busy = false;
+}
+
+/**
+ * @brief DMA error and abort callback: stops the timer and ends the frame.
+ *
+ * The waveform stopped part way, so STB may still be low. Raising it (with
+ * CLK and DIO back at their idle level) makes the chip drop the partial
+ * frame; the data itself is lost. Without this the bus stayed busy forever.
+ *
+ * @param hdma DMA handle whose Parent points to the TM1638 handle.
+ */
+static void tm1638_wave_dma_error(DMA_HandleTypeDef *hdma) {
+    TM1638 *tm = (TM1638 *)hdma->Parent;
+
+    HAL_TIM_Base_Stop(tm->htim);
+    __HAL_TIM_DISABLE_DMA(tm->htim, TIM_DMA_UPDATE);
+    // Frames only go through DMA when all three lines share a port
+    tm->stb_port->BSRR = tm->clk_set | tm->dio_set | tm->stb_set;
+    tm->tx_busy = false;
+}
+
+const TM1638_Transport tm1638_transport_tim_dma = {
+    .init = tm1638_wave_init,
+    .begin = tm1638_wave_begin,
+    .end = tm1638_reg_end,
+    .write = tm1638_reg_write,
+    .read = tm1638_reg_read,
+    .send_frame = tm1638_wave_send_frame,
+    // Each frame is a separate DMA request, so favour long bursts
+    .stb_cycle_cost = 64,
+};
+
+#endif /* TM1638_ENABLE_TIM_DMA */
+
+// --- Parallel Modules ---
+
+static bool tm1638_parallel_same_port(const TM1638 *modules, uint8_t count);
+static void tm1638_parallel_send(TM1638_Parallel *par, const uint8_t *frames, uint8_t len);
+
+/**
+ * @brief Initializes a group of modules driven in parallel on one GPIO port.
+ * @param par Pointer to the parallel group.
+ * @param modules Array of count module handles.
+ * @param count Number of modules (1 to TM1638_PARALLEL_MAX_MODULES).
+ * @param brightness Initial brightness level (0-7).
+ * @return true on success, false if the count is out of range or the pins
+ *         do not share one port.
+ */
+bool tm1638_parallel_init(TM1638_Parallel *par, TM1638 *modules, uint8_t count, uint8_t brightness) {
+    par->modules = modules;
+    par->count = 0;
+    par->dio_mask = 0;
+    par->stb_mask = 0;
+    memset(par->dio_low, 0, sizeof(par->dio_low));
+    memset(par->dio_high, 0, sizeof(par->dio_high));
+
+    // The group functions size their stack buffers by TM1638_PARALLEL_MAX_MODULES,
+    // and a module on another port would miss the edges while sharing STB
+    if (count == 0 || count > TM1638_PARALLEL_MAX_MODULES || !tm1638_parallel_same_port(modules, count)) {
+        return false;
+    }
+    par->count = count;
+    if (brightness > 7) {
+        brightness = 7;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        tm1638_setup(&modules[i], &tm1638_transport_reg, brightness);
+        par->dio_mask |= modules[i].dio_pin;
+        par->stb_mask |= modules[i].stb_pin;
+        modules[i].dirty = 0xFFFF; // Chip RAM content is unknown after power-up
+        // Every nibble pattern with this module's lane bit set drives its pin
+        uint32_t *dio_table = (i < 4) ? par->dio_low : par->dio_high;
+        for (uint8_t v = 0; v < 16; v++) {
+            if (v & (1U << (i & 3))) {
+                dio_table[v] |= modules[i].dio_pin;
+            }
+        }
+    }
+    tm1638_parallel_flush(par);
+    tm1638_parallel_set_brightness(par, brightness);
+    return true;
+}
+
+/**
+ * @brief Sets the brightness of every module of the group.
+ * @param par Pointer to the parallel group.
+ * @param brightness The brightness level, from 0 (dimmest) to 7 (brightest).
+ */
+void tm1638_parallel_set_brightness(TM1638_Parallel *par, uint8_t brightness) {
+    uint8_t command[TM1638_PARALLEL_MAX_MODULES];
+
+    if (par->count == 0) {
+        return; // Rejected by tm1638_parallel_init()
+    }
+    if (brightness > 7) {
+        // Clamp brightness to the maximum value if out of range
+        brightness = 7;
+    }
+#ifdef TM1638_ENABLE_STATS
+    uint32_t start = TM1638_CYCLES();
+#endif
+    for (uint8_t m = 0; m < par->count; m++) {
+        par->modules[m].brightness = brightness;
+    }
+    memset(command, CMD_DISPLAY_CTRL | DISPLAY_ON_MASK | brightness, par->count);
+    tm1638_parallel_send(par, command, 1);
+#ifdef TM1638_ENABLE_STATS
+    for (uint8_t m = 0; m < par->count; m++) {
+        tm1638_stats_op(&par->modules[m].stats.brightness, start);
+    }
+#endif
+}
+
+/**
+ * @brief Flushes all modules of the group in one bit-sliced pass.
+ * @param par Pointer to the parallel group.
+ */
+void tm1638_parallel_flush(TM1638_Parallel *par) {
+    // Frame bytes of every module, interleaved: frames[byte * count + module]
+    uint8_t frames[TM1638_MAX_FRAME_SIZE * TM1638_PARALLEL_MAX_MODULES];
+    uint8_t command[TM1638_PARALLEL_MAX_MODULES];
+    uint16_t dirty = 0;
+    uint8_t first = 0;
+    uint8_t last = TM1638_RAM_SIZE - 1;
+    uint8_t count = par->count;
+
+    for (uint8_t m = 0; m < count; m++) {
+        dirty |= par->modules[m].dirty;
+    }
+    if (dirty == 0) {
+        return;
+    }
+#ifdef TM1638_ENABLE_STATS
+    uint32_t start = TM1638_CYCLES();
+#endif
+    // One burst covering every module's changes
+    while (!(dirty & (1U << first))) {
+        first++;
+    }
+    while (!(dirty & (1U << last))) {
+        last--;
+    }
+
+    for (uint8_t m = 0; m < count; m++) {
+        frames[m] = CMD_ADDRESS_SET | first;
+        for (uint8_t i = first; i <= last; i++) {
+            frames[(i - first + 1) * count + m] = par->modules[m].display_ram[i];
+        }
+        par->modules[m].dirty = 0;
+    }
+
+    memset(command, CMD_DATA_SET_AUTO_INC, count);
+    tm1638_parallel_send(par, command, 1);
+    tm1638_parallel_send(par, frames, (uint8_t)(last - first + 2));
+#ifdef TM1638_ENABLE_STATS
+    // The group pass is every module's flush
+    for (uint8_t m = 0; m < count; m++) {
+        tm1638_stats_op(&par->modules[m].stats.flush, start);
+    }
+#endif
+}
+
+/**
+ * @brief Checks that CLK, DIO and STB of every module are on one port with a shared CLK.
+ * @param modules Array of count module handles.
+ * @param count Number of modules.
+ * @return True if a single BSRR can drive the whole group.
+ */
+static bool tm1638_parallel_same_port(const TM1638 *modules, uint8_t count) {
+    for (uint8_t m = 0; m < count; m++) {
+        const TM1638 *tm = &modules[m];
+        if (tm->clk_port != modules[0].clk_port || tm->clk_pin != modules[0].clk_pin ||
+            tm->dio_port != tm->clk_port || tm->stb_port != tm->clk_port) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Transposes an 8 x 8 bit matrix held in a 64-bit word.
+ *
+ * Bit b of byte m moves to bit m of byte b, in three rounds of swapping
+ * 1 x 1, 2 x 2 and 4 x 4 blocks across the diagonal.
+ *
+ * @param x Byte m is row m of the matrix.
+ * @return Byte b is column b of the matrix.
+ */
+static uint64_t tm1638_transpose8(uint64_t x) {
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+/**
+ * @brief Clocks one transaction into every module at once.
+ *
+ * Before STB goes low, each frame byte of all modules is transposed into
+ * eight lanes, lane b holding bit b of module m at bit m. Per clock the lane
+ * is turned into DIO pins with two nibble lookups: modules whose bit is 1
+ * get their DIO pin in the BSRR set half, the others in the reset half,
+ * together with CLK low. The clock loop is then branch-free and as short as
+ * a single module's, and the CLK times of modules[0] apply to the group.
+ *
+ * @param par Pointer to the parallel group.
+ * @param frames Interleaved frame bytes: frames[byte * count + module].
+ * @param len Number of bytes per module.
+ */
+static void tm1638_parallel_send(TM1638_Parallel *par, const uint8_t *frames, uint8_t len) {
+    GPIO_TypeDef *port = par->modules[0].clk_port;
+    const uint32_t clk_set = par->modules[0].clk_set;
+    const uint32_t clk_reset = par->modules[0].clk_reset;
+    const uint16_t low_cycles = par->modules[0].clk_low_cycles;
+    const uint16_t high_cycles = par->modules[0].clk_high_cycles;
+    const uint8_t count = par->count;
+    uint64_t lanes[TM1638_MAX_FRAME_SIZE];
+
+    for (uint8_t n = 0; n < len; n++) {
+        const uint8_t *bytes = &frames[n * count];
+        uint64_t rows = 0;
+        for (uint8_t m = 0; m < count; m++) {
+            rows |= (uint64_t)bytes[m] << (8 * m);
+        }
+        lanes[n] = tm1638_transpose8(rows);
+    }
+
+    port->BSRR = par->stb_mask << 16;
+    for (uint8_t n = 0; n < len; n++) {
+        uint64_t lane = lanes[n];
+        for (uint8_t b = 0; b < 8; b++, lane >>= 8) {
+            const uint32_t set = par->dio_low[lane & 0x0F] | par->dio_high[(lane >> 4) & 0x0F];
+            port->BSRR = clk_reset | set | ((par->dio_mask & ~set) << 16);
+            tm1638_delay_cycles(low_cycles);
+            port->BSRR = clk_set;
+            tm1638_delay_cycles(high_cycles);
+        }
+    }
+    port->BSRR = par->stb_mask;
+#ifdef TM1638_ENABLE_STATS
+    for (uint8_t m = 0; m < count; m++) {
+        tm1638_stats_bus(&par->modules[m], len, 0);
+    }
+#endif
+}
+
+#endif /* TM1638_NO_HAL */
@@ -14,13 +14,238 @@
 #define TM1638_H_
 
 #include <stdbool.h>
+#include <stdint.h>
+#ifndef TM1638_NO_HAL
 #include "stm32f4xx_hal.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// --- Configuration ---
 
 /**
- * @brief Structure to hold the configuration for a TM1638 module.
+ * @brief Define TM1638_NO_HAL to build the driver without the STM32 HAL.
+ *
+ * Only the protocol logic is compiled then, and every handle must be set up
+ * with tm1638_init_transport() and a transport of your own (e.g. a host
+ * simulator).
+ */
+
+/** @brief Transports selectable with TM1638_BACKEND as the tm1638_init() default. */
+#define TM1638_BACKEND_HAL 0 ///< HAL_GPIO_WritePin / HAL_GPIO_ReadPin (default)
+#define TM1638_BACKEND_REG 1 ///< Direct GPIOx->BSRR writes and GPIOx->IDR reads
+#define TM1638_BACKEND_SPI 2 ///< SPI peripheral in half-duplex mode, flushes by DMA
+#define TM1638_BACKEND_TIM_DMA 3 ///< Timer-paced DMA of precomputed BSRR words, flushes only
+
+/**
+ * @brief Selects the transport tm1638_init() uses to toggle CLK, DIO and STB.
+ *
+ * TM1638_BACKEND_REG skips the HAL and writes precomputed set/reset masks
+ * straight to the port BSRR register, which makes every clocked bit several
+ * times cheaper. TM1638_BACKEND_SPI hands CLK and DIO to an SPI peripheral
+ * and only drives STB as a GPIO. TM1638_BACKEND_TIM_DMA behaves like the
+ * register backend, but plays flush frames into BSRR from a timer-triggered
+ * DMA stream. Select it from the compiler flags
+ * (e.g. -DTM1638_BACKEND=TM1638_BACKEND_REG). Any compiled-in transport can
+ * also be picked per handle with tm1638_init_transport().
+ */
+#ifndef TM1638_BACKEND
+#define TM1638_BACKEND TM1638_BACKEND_HAL
+#endif
+
+#ifndef TM1638_NO_HAL
+
+#if TM1638_BACKEND == TM1638_BACKEND_SPI && !defined(HAL_SPI_MODULE_ENABLED)
+#error "TM1638_BACKEND_SPI requires HAL_SPI_MODULE_ENABLED in stm32f4xx_hal_conf.h"
+#endif
+
+/**
+ * @brief Compiles the timer + DMA waveform transport.
+ *
+ * Opt-in because it adds a ~1 KB BSRR word buffer to every handle. Implied
+ * by TM1638_BACKEND_TIM_DMA.
+ */
+#if TM1638_BACKEND == TM1638_BACKEND_TIM_DMA && !defined(TM1638_ENABLE_TIM_DMA)
+#define TM1638_ENABLE_TIM_DMA
+#endif
+
+#ifdef TM1638_ENABLE_TIM_DMA
+#if !defined(HAL_DMA_MODULE_ENABLED) || !defined(HAL_TIM_MODULE_ENABLED)
+#error "TM1638_ENABLE_TIM_DMA requires HAL_DMA_MODULE_ENABLED and HAL_TIM_MODULE_ENABLED"
+#endif
+#endif
+
+/**
+ * @brief Define TM1638_USE_TX_TABLE to clock bytes out of a lookup table in
+ *        the register transport (and the timer + DMA fallback path).
+ *
+ * A 256 x 8 table (2 KB of flash) holds the DIO edge of every bit of every
+ * byte, so the byte loop is unrolled and has no data-dependent branch.
  */
+
+/** @brief Twait: time from the read command to the first key data clock (datasheet: at least 1 us). */
+#ifndef TM1638_TWAIT_NS
+#define TM1638_TWAIT_NS 1000
+#endif
+
+/** @brief Timeout for blocking SPI command and key-read transfers. */
+#ifndef TM1638_SPI_TIMEOUT_MS
+#define TM1638_SPI_TIMEOUT_MS 10
+#endif
+
+#endif /* TM1638_NO_HAL */
+
+/** @brief Largest frame sent by a flush: one address byte plus the 16 display registers. */
+#define TM1638_MAX_FRAME_SIZE 17
+
+/**
+ * @brief BSRR words needed to play the largest frame: STB low, two words per
+ *        bit (CLK low with the data, CLK high) and STB high.
+ */
+#define TM1638_WAVE_MAX_WORDS (2 + TM1638_MAX_FRAME_SIZE * 16)
+
+/** @brief Largest group handled by tm1638_parallel_flush() (bounds its stack buffer). */
+#ifndef TM1638_PARALLEL_MAX_MODULES
+#define TM1638_PARALLEL_MAX_MODULES 8
+#endif
+#if TM1638_PARALLEL_MAX_MODULES > 8
+#error "TM1638_PARALLEL_MAX_MODULES must be at most 8 (one bit per module in a transposed byte)"
+#endif
+
+/**
+ * @brief Bus cost of one extra STB low/high cycle for the bit-banged
+ *        transports, expressed in clocked bits.
+ *
+ * tm1638_flush() weighs this against the cost of rewriting unchanged
+ * registers when it plans a write. Override it from the compiler flags
+ * (e.g. -DTM1638_STB_CYCLE_COST=4) if your STB line is slow to toggle.
+ */
+#ifndef TM1638_STB_CYCLE_COST
+#define TM1638_STB_CYCLE_COST 2
+#endif
+
+/** @brief Number of key events a TM1638_Keypad can buffer (a power of two, at most 128). */
+#ifndef TM1638_KEY_QUEUE_SIZE
+#define TM1638_KEY_QUEUE_SIZE 16
+#endif
+
+#if TM1638_KEY_QUEUE_SIZE < 2 || TM1638_KEY_QUEUE_SIZE > 128 || (TM1638_KEY_QUEUE_SIZE & (TM1638_KEY_QUEUE_SIZE - 1)) != 0
+#error "TM1638_KEY_QUEUE_SIZE must be a power of two between 2 and 128"
+#endif
+
+/** @brief Initial debounce time of every key, in milliseconds. */
+#ifndef TM1638_DEBOUNCE_MS
+#define TM1638_DEBOUNCE_MS 20
+#endif
+
+/** @brief Initial time a key must stay down before a hold event, in milliseconds (0: never). */
+#ifndef TM1638_HOLD_MS
+#define TM1638_HOLD_MS 1000
+#endif
+
+/** @brief Number of key chords a TM1638_Keypad can watch. */
+#ifndef TM1638_MAX_CHORDS
+#define TM1638_MAX_CHORDS 4
+#endif
+
+#if TM1638_MAX_CHORDS > 8
+#error "TM1638_MAX_CHORDS must be at most 8"
+#endif
+
+/** @brief Initial key scan intervals of tm1638_wait_event(), in milliseconds. */
+#ifndef TM1638_IDLE_SCAN_MS
+#define TM1638_IDLE_SCAN_MS 50 ///< While no key has been touched for TM1638_ACTIVE_HOLDOFF_MS
+#endif
+#ifndef TM1638_ACTIVE_SCAN_MS
+#define TM1638_ACTIVE_SCAN_MS 5 ///< While keys are down and shortly after
+#endif
+
+/** @brief Time after the last key activity during which tm1638_wait_event() keeps scanning fast. */
+#ifndef TM1638_ACTIVE_HOLDOFF_MS
+#define TM1638_ACTIVE_HOLDOFF_MS 2000
+#endif
+
+/**
+ * @brief Define TM1638_ENABLE_STATS to count bus traffic and time driver
+ *        operations per handle, read back with tm1638_get_stats().
+ *
+ * Cycles are read with TM1638_CYCLES(), the DWT cycle counter by default
+ * (enabled by the init functions). Define TM1638_CYCLES() as another
+ * free-running 32-bit counter on other targets; without the HAL and without
+ * a definition, only the counters are kept.
+ */
+
+typedef struct TM1638 TM1638;
+
+#ifdef TM1638_ENABLE_STATS
+/** @brief Cycle statistics of one kind of operation. */
+typedef struct {
+    uint32_t count;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles; // Average: total_cycles / count
+} TM1638_OpStats;
+
+/** @brief Runtime statistics of a handle (TM1638_ENABLE_STATS). */
 typedef struct {
+    // STB-framed bus transactions, bytes clocked out and in, key scans
+    uint32_t transactions;
+    uint32_t bytes_sent;
+    uint32_t bytes_received;
+    uint32_t scans;
+
+    // Flushes with pending changes, key scans and brightness changes, of the
+    // handle alone or of its parallel group
+    TM1638_OpStats flush;
+    TM1638_OpStats scan;
+    TM1638_OpStats brightness;
+} TM1638_Stats;
+#endif
+
+/**
+ * @brief Bus operations used by the driver to talk to a TM1638.
+ *
+ * A transaction is begin() (STB low), any number of write()/read() calls
+ * and end() (STB high). Data is LSB first on the wire.
+ */
+typedef struct {
+    // Optional: called by tm1638_init_transport() before the first transaction
+    void (*init)(TM1638 *tm);
+
+    // Pull STB low; must wait for any frame still sent in the background
+    void (*begin)(TM1638 *tm);
+
+    // Pull STB high
+    void (*end)(TM1638 *tm);
+
+    // Clock out len bytes
+    void (*write)(TM1638 *tm, const uint8_t *data, uint8_t len);
+
+    // Clock in len bytes (key scan data)
+    void (*read)(TM1638 *tm, uint8_t *data, uint8_t len);
+
+    // Optional: send a whole STB-framed transaction, possibly in the background
+    void (*send_frame)(TM1638 *tm, const uint8_t *frame, uint8_t len);
+
+    // Cost of an extra transaction's STB cycle in clocked bits, see TM1638_STB_CYCLE_COST
+    uint8_t stb_cycle_cost;
+} TM1638_Transport;
+
+/**
+ * @brief Structure to hold the configuration for a TM1638 module.
+ */
+struct TM1638 {
+    // Bus implementation, set by tm1638_init() / tm1638_init_transport()
+    const TM1638_Transport *transport;
+
+    // Free for custom transports (e.g. a simulator instance)
+    void *transport_ctx;
+
+#ifndef TM1638_NO_HAL
     // GPIO Port and Pin for the CLK (Clock) line
+    // (unused by the SPI transport, where CLK and DIO are driven by hspi)
     GPIO_TypeDef *clk_port;
     uint16_t clk_pin;
 
@@ -32,19 +257,264 @@ typedef struct {
     GPIO_TypeDef *stb_port;
     uint16_t stb_pin;
 
+    // BSRR words computed by the register transport (set in bits 0-15, reset in bits 16-31)
+    uint32_t clk_set, clk_reset;
+    uint32_t dio_set, dio_reset;
+    uint32_t stb_set, stb_reset;
+
+    // MODER field of the DIO pin and its output-mode value, used to turn DIO
+    // around for key reads with one read-modify-write
+    uint32_t dio_moder_mask;
+    uint32_t dio_moder_output;
+
+    // Set by tm1638_init when DIO is configured as open-drain output: the pin
+    // then stays an output and is simply released high for key reads
+    bool dio_open_drain;
+
+    // Extra CLK low / high time per bit of the HAL and register transports, in
+    // core cycles (0: full speed), set by tm1638_set_timing() or
+    // tm1638_calibrate_timing()
+    uint16_t clk_low_cycles;
+    uint16_t clk_high_cycles;
+
+    // TM1638_TWAIT_NS in core cycles, computed by the transport init: the wait
+    // between turning DIO around and the first key data clock
+    uint16_t twait_cycles;
+
+#ifdef HAL_SPI_MODULE_ENABLED
+    // SPI peripheral: half-duplex master, 8-bit, LSB first, CPOL high, CPHA 2nd edge.
+    // Set dio_port/dio_pin to the MOSI pin so init enables its pull-up.
+    SPI_HandleTypeDef *hspi;
+
+    // DMA source buffer for the frame in flight
+    uint8_t spi_frame[TM1638_MAX_FRAME_SIZE];
+#endif
+
+#ifdef TM1638_ENABLE_TIM_DMA
+    // Timer whose update event paces the DMA (two events per clocked bit), and the
+    // DMA stream moving words to BSRR (memory-to-peripheral, word, normal mode).
+    // Only TIM1_UP / TIM8_UP on DMA2 can reach the GPIO ports on the F4.
+    // CLK, DIO and STB must share one port for a frame to be played by DMA.
+    TIM_HandleTypeDef *htim;
+    DMA_HandleTypeDef *hdma;
+
+    // BSRR word stream of the frame in flight
+    uint32_t wave[TM1638_WAVE_MAX_WORDS];
+#endif
+#endif /* TM1638_NO_HAL */
+
+    // True while a DMA frame is on the wire and STB is still held low
+    volatile bool tx_busy;
+
     // Current brightness level (0-7)
     uint8_t brightness;
 
-} TM1638;
+    // Shadow copy of the 16 display registers (even: segments, odd: LEDs)
+    uint8_t display_ram[16];
+
+    // Bit n is set when display_ram[n] has not been sent to the chip yet
+    uint16_t dirty;
+
+#ifdef TM1638_ENABLE_STATS
+    // Runtime statistics, see tm1638_get_stats()
+    TM1638_Stats stats;
+#endif
+
+};
+
+/**
+ * @brief Several TM1638 modules sharing CLK and DIO, each with its own STB line.
+ *
+ * Commands meant for every module (brightness, clear) are clocked out once
+ * with all STB lines held low together. Only synchronous transports (HAL,
+ * register, or a custom one without send_frame) can be shared this way.
+ */
+typedef struct {
+    // Array of count module handles; each one sets its own STB pin
+    TM1638 *modules;
+    uint8_t count;
+} TM1638_Bus;
+
+/** @brief Keys in the TM1638 scan matrix (K1-K3 x KS1-KS8). */
+#define TM1638_MATRIX_KEYS 24
+
+/**
+ * @brief Maps the key matrix of a board to its numbered keys.
+ *
+ * tm1638_scan_matrix() returns the 24 matrix positions as read: byte n (bits
+ * 8n-8n+7) holds KS(2n+1) in bits 0-2 and KS(2n+2) in bits 4-6, with K3, K2
+ * and K1 in that order. key_bit[i] is the matrix bit wired to key S(i+1).
+ */
+typedef struct {
+    uint8_t key_count;
+    uint8_t key_bit[TM1638_MATRIX_KEYS];
+} TM1638_Board;
+
+/** @brief "LED&KEY" boards: 8 keys S1-S8 on K2. */
+extern const TM1638_Board tm1638_board_led_key;
+
+/** @brief "QYF" boards: 16 keys, S1-S8 on K2 as on LED&KEY and S9-S16 on K3. */
+extern const TM1638_Board tm1638_board_qyf;
+
+/** @brief Kinds of key events reported by a TM1638_Keypad. */
+typedef enum {
+    TM1638_KEY_PRESS,   ///< Key went down (after debouncing)
+    TM1638_KEY_RELEASE, ///< Key went up (after debouncing)
+    TM1638_KEY_HOLD,    ///< Key has been down for the hold time, sent once per press (long press)
+    TM1638_KEY_REPEAT,  ///< Auto-repeat of a key held down, see tm1638_keypad_set_repeat()
+    TM1638_KEY_CHORD,   ///< All keys of a chord are down; key is the chord number
+} TM1638_KeyEventType;
+
+/** @brief A debounced key event. */
+typedef struct {
+    uint8_t key;              // Key number, 1 = S1 (chord number for TM1638_KEY_CHORD)
+    TM1638_KeyEventType type;
+    uint32_t time_ms;         // Time the state change began (PRESS/RELEASE) or was reached (others)
+} TM1638_KeyEvent;
+
+/**
+ * @brief Debounces the keys of one module and queues their events.
+ *
+ * Driven by tm1638_poll(); every key has its own debounce time. The event
+ * queue is a lock-free single-producer/single-consumer ring: tm1638_poll()
+ * may run in an interrupt while tm1638_get_event() is called from the main
+ * loop or a task, without disabling interrupts.
+ */
+typedef struct {
+    TM1638 *tm;
+
+    // Key layout; NULL reads the 8 keys of tm1638_scan_buttons()
+    const TM1638_Board *board;
+    uint8_t key_count;
+
+    // Time a key's raw state must stay unchanged before it is accepted
+    uint8_t debounce_ms[TM1638_MATRIX_KEYS];
+
+    // Time a key must stay down before TM1638_KEY_HOLD (0: never)
+    uint16_t hold_ms;
+
+    // Last raw sample, debounced state and keys whose hold event was sent (bit i: S(i+1))
+    uint32_t raw;
+    uint32_t stable;
+    uint32_t held;
+
+    // Time of the last raw change, and of the accepted press, of every key
+    uint32_t changed_ms[TM1638_MATRIX_KEYS];
+    uint32_t pressed_ms[TM1638_MATRIX_KEYS];
+
+    // Auto-repeat: keys that repeat, delay before the first repeat, first and
+    // shortest interval (each repeat shortens the interval by 1/8)
+    uint32_t repeat_keys;
+    uint16_t repeat_delay_ms;
+    uint16_t repeat_start_ms;
+    uint16_t repeat_min_ms;
+
+    // Time of the next repeat and current repeat interval of every key
+    uint32_t next_repeat_ms[TM1638_MATRIX_KEYS];
+    uint16_t repeat_interval_ms[TM1638_MATRIX_KEYS];
+
+    // Key masks of the chords, and the chords whose event was sent (bit c: chord c+1)
+    uint32_t chords[TM1638_MAX_CHORDS];
+    uint8_t chord_count;
+    uint8_t chords_down;
+
+    // tm1638_wait_event(): scan interval while idle and while keys are in use,
+    // and time a key was last seen down
+    uint8_t idle_scan_ms;
+    uint8_t active_scan_ms;
+    uint32_t activity_ms;
+
+    // Measured by tm1638_wait_event(): core cycles spent awake (DWT CYCCNT,
+    // which stops while the core sleeps) and milliseconds spent waiting
+    uint64_t awake_cycles;
+    uint32_t wait_ms;
+
+    // Event ring: head is only written by the producer (tm1638_poll()) and
+    // tail only by the consumer (tm1638_get_event()); both run freely and are
+    // masked on access. Events arriving while it is full are counted and dropped.
+    TM1638_KeyEvent queue[TM1638_KEY_QUEUE_SIZE];
+    uint8_t head, tail;
+    uint32_t dropped;
+} TM1638_Keypad;
+
+#ifndef TM1638_NO_HAL
+/**
+ * @brief Modules whose DIO lines sit on one GPIO port, driven in parallel.
+ *
+ * CLK is shared and every module has its own DIO pin, all on the same
+ * port. STB lines (on that port too) may be shared or one per module.
+ * A single BSRR write then presents one bit to every module at once, so
+ * the group takes as many port writes per flush as a single module.
+ */
+typedef struct {
+    // Array of count module handles (same clk pin, distinct dio pins)
+    TM1638 *modules;
+    uint8_t count;
+
+    // OR of the DIO pins and of the STB pins of all modules
+    uint32_t dio_mask;
+    uint32_t stb_mask;
+
+    // DIO pins to set for each bit pattern of modules 0-3 and 4-7
+    uint32_t dio_low[16];
+    uint32_t dio_high[16];
+} TM1638_Parallel;
+
+// --- STM32 HAL Transports ---
+
+/** @brief Bit-banged through HAL_GPIO_WritePin / HAL_GPIO_ReadPin. */
+extern const TM1638_Transport tm1638_transport_hal;
+
+/** @brief Bit-banged through direct GPIOx->BSRR / GPIOx->IDR accesses. */
+extern const TM1638_Transport tm1638_transport_reg;
+
+#ifdef HAL_SPI_MODULE_ENABLED
+/** @brief Half-duplex SPI (hspi), flush frames sent by DMA. */
+extern const TM1638_Transport tm1638_transport_spi;
+#endif
+
+#ifdef TM1638_ENABLE_TIM_DMA
+/** @brief Register transport with flush frames played into BSRR by timer-paced DMA. */
+extern const TM1638_Transport tm1638_transport_tim_dma;
+#endif
+
+#if TM1638_BACKEND == TM1638_BACKEND_REG
+#define TM1638_DEFAULT_TRANSPORT tm1638_transport_reg
+#elif TM1638_BACKEND == TM1638_BACKEND_SPI
+#define TM1638_DEFAULT_TRANSPORT tm1638_transport_spi
+#elif TM1638_BACKEND == TM1638_BACKEND_TIM_DMA
+#define TM1638_DEFAULT_TRANSPORT tm1638_transport_tim_dma
+#else
+#define TM1638_DEFAULT_TRANSPORT tm1638_transport_hal
+#endif
+#endif /* TM1638_NO_HAL */
 
 // --- Public Function Prototypes ---
 
+#ifndef TM1638_NO_HAL
 /**
  * @brief Initializes the TM1638 module. Must be called before any other function.
+ *
+ * Uses the transport selected by TM1638_BACKEND. Clears the shadow
+ * framebuffer and writes it to the chip, so the display starts blank.
+ *
  * @param tm Pointer to the TM1638 handle.
  * @param brightness Initial brightness level (0-7).
  */
 void tm1638_init(TM1638 *tm, uint8_t brightness);
+#endif
+
+/**
+ * @brief Initializes the TM1638 module on an explicit transport.
+ *
+ * Same as tm1638_init(), but the bus implementation is chosen by the caller.
+ * The pin / peripheral fields the transport needs must be set beforehand.
+ *
+ * @param tm Pointer to the TM1638 handle.
+ * @param transport The bus implementation, e.g. &tm1638_transport_reg.
+ * @param brightness Initial brightness level (0-7).
+ */
+void tm1638_init_transport(TM1638 *tm, const TM1638_Transport *transport, uint8_t brightness);
 
 /**
  * @brief Sets the brightness of the displays and LEDs.
@@ -55,6 +525,9 @@ void tm1638_set_brightness(TM1638 *tm, uint8_t brightness);
 
 /**
  * @brief Clears all displays and turns off all LEDs.
+ *
+ * Only the framebuffer is updated; call tm1638_flush() to show the result.
+ *
  * @param tm Pointer to the TM1638 handle.
  */
 void tm1638_display_clear(TM1638 *tm);
@@ -65,6 +538,8 @@ void tm1638_display_clear(TM1638 *tm);
  * @param position The display position (1-8, from left to right).
  * @param c The character to display (e.g., '0'-'9', 'A', 'b', etc.).
  * @param dot If true, the decimal point for that segment is turned on.
+ *
+ * Only the framebuffer is updated; call tm1638_flush() to show the result.
  */
 void tm1638_display_char(TM1638 *tm, uint8_t position, char c, bool dot);
 
@@ -74,6 +549,7 @@ void tm1638_display_char(TM1638 *tm, uint8_t position, char c, bool dot);
  * The string is right-aligned. It automatically handles decimal points.
  * For example, "12.34" will be displayed as "  12.34".
  * If the string (excluding dots) is longer than 8 characters, it will be truncated.
+ * Only the framebuffer is updated; call tm1638_flush() to show the result.
  *
  * @param tm Pointer to the TM1638 handle.
  * @param str The null-terminated string to display.
@@ -86,6 +562,8 @@ void tm1638_display_txt(TM1638 *tm, const char *str);
  * @param tm Pointer to the TM1638 handle.
  * @param position The LED position (1-8, from left to right).
  * @param on True to turn the LED on, false to turn it off.
+ *
+ * Only the framebuffer is updated; call tm1638_flush() to show the result.
  */
 void tm1638_set_led(TM1638 *tm, uint8_t position, bool on);
 
@@ -93,6 +571,7 @@ void tm1638_set_led(TM1638 *tm, uint8_t position, bool on);
  * @brief Sets the raw 8-bit segment data for a single display position.
  *
  * This allows for custom symbols or direct control over the segments.
+ * Only the framebuffer is updated; call tm1638_flush() to show the result.
  * 
  * Bit mapping: 0b(DP)(G)(F)(E)(D)(C)(B)(A)
  * 
@@ -104,6 +583,106 @@ void tm1638_set_led(TM1638 *tm, uint8_t position, bool on);
  */
 void tm1638_set_segment(TM1638 *tm, uint8_t position, uint8_t data);
 
+/**
+ * @brief Sets all 8 digits from prebuilt segment codes.
+ *
+ * Meant for fixed messages encoded ahead of time (see tm1638::encode() in
+ * TM1638.hpp), so no string parsing or glyph lookup happens at runtime.
+ * Only the framebuffer is updated; call tm1638_flush() to show the result.
+ *
+ * @param tm Pointer to the TM1638 handle.
+ * @param segments Segment codes for positions 1-8, left to right.
+ */
+void tm1638_display_raw8(TM1638 *tm, const uint8_t segments[8]);
+
+/**
+ * @brief Sends every framebuffer register that changed since the last flush.
+ *
+ * Registers whose value did not change are not transmitted, so calling this
+ * at a fixed refresh rate only costs bus time when something was redrawn.
+ *
+ * The write is planned to need the fewest clocked bits and STB cycles:
+ * a single auto-increment burst, several auto-increment runs, or individual
+ * fixed-address writes for scattered registers.
+ *
+ * @param tm Pointer to the TM1638 handle.
+ */
+void tm1638_flush(TM1638 *tm);
+
+#ifdef TM1638_ENABLE_STATS
+/**
+ * @brief Copies the runtime statistics of a handle.
+ *
+ * Broadcasts of a TM1638_Bus are counted on its first module.
+ *
+ * @param tm Pointer to the TM1638 handle.
+ * @param stats Receives the statistics.
+ */
+void tm1638_get_stats(const TM1638 *tm, TM1638_Stats *stats);
+
+/**
+ * @brief Clears the runtime statistics of a handle.
+ * @param tm Pointer to the TM1638 handle.
+ */
+void tm1638_reset_stats(TM1638 *tm);
+#endif
+
+#if !defined(TM1638_NO_HAL) && defined(HAL_SPI_MODULE_ENABLED)
+/**
+ * @brief Completes a DMA transfer started by tm1638_flush().
+ *
+ * With the SPI transport the last frame of a flush is still being sent when
+ * tm1638_flush() returns. Call this from HAL_SPI_TxCpltCallback() for the
+ * SPI instance used by the module so STB is released and the bus freed.
+ *
+ * @param tm Pointer to the TM1638 handle.
+ */
+void tm1638_spi_tx_complete(TM1638 *tm);
+#endif
+
+#ifndef TM1638_NO_HAL
+/**
+ * @brief Sets the CLK low and high times of the bit-banged transports.
+ *
+ * The HAL and register transports wait this long (DWT cycle delays, from
+ * SystemCoreClock) after each CLK edge on top of their own run time; 0 runs
+ * them at full speed, which is the default. On a fast core full speed can
+ * exceed the datasheet's 1 MHz clock (400 ns per phase);
+ * tm1638_calibrate_timing() never sets less than that. Key reads also wait
+ * the low time before sampling DIO. The SPI and timer + DMA transports take their bit
+ * rate from the peripheral configuration instead.
+ *
+ * @param tm Pointer to the TM1638 handle.
+ * @param low_ns Extra CLK low time in nanoseconds.
+ * @param high_ns Extra CLK high time in nanoseconds.
+ */
+void tm1638_set_timing(TM1638 *tm, uint32_t low_ns, uint32_t high_ns);
+
+/**
+ * @brief Finds the fastest clock the wiring handles reliably, then sets it with a safety margin.
+ *
+ * Starting slow, the CLK low/high time is halved step by step down to the
+ * datasheet's 400 ns per phase (1 MHz clock), with several key scans at each
+ * step. Each scan sends the read command, waits Twait and clocks in the key
+ * data, all at the timing under test. A read is valid when its reserved bits
+ * (3 and 7 of every byte) are 0, when it is not all 0xFF (the read command
+ * was not understood, so nobody drove DIO) and when repeated reads agree. The
+ * shortest time whose reads all pass, plus margin_percent of it, is kept for
+ * both reads and writes.
+ *
+ * Only the read path is verified: the display registers cannot be read back,
+ * so no write pattern is checked, and writes rely on the chip taking data at
+ * least as fast as it shifts out key data. Do not touch the keys while it
+ * runs. The display content and brightness are sent again afterwards.
+ *
+ * @param tm Pointer to an initialized TM1638 handle on the HAL or register transport.
+ * @param margin_percent Safety margin added to the shortest passing time (e.g. 50).
+ * @return The CLK low/high time kept, in nanoseconds, or UINT32_MAX if even
+ *         the slowest step failed (the slowest timing is kept then).
+ */
+uint32_t tm1638_calibrate_timing(TM1638 *tm, uint8_t margin_percent);
+#endif
+
 /**
  * @brief Scans the keypad and returns a bitmask of pressed buttons.
  *
@@ -115,6 +694,26 @@ void tm1638_set_segment(TM1638 *tm, uint8_t position, uint8_t data);
  */
 uint8_t tm1638_scan_buttons(TM1638 *tm);
 
+/**
+ * @brief Reads the whole key matrix (K1-K3 x KS1-KS8).
+ *
+ * This is a non-blocking function. See TM1638_Board for the bit layout;
+ * tm1638_map_keys() turns the result into numbered keys.
+ *
+ * @param tm Pointer to the TM1638 handle.
+ * @return The 32-bit matrix bitmap (bits 3 and 7 of every byte are always 0).
+ */
+uint32_t tm1638_scan_matrix(TM1638 *tm);
+
+/**
+ * @brief Converts a matrix bitmap into the keys of a board.
+ * @param board The board profile (e.g. &tm1638_board_qyf).
+ * @param matrix Bitmap returned by tm1638_scan_matrix().
+ * @return Bit i is set when key S(i+1) is pressed.
+ */
+uint32_t tm1638_map_keys(const TM1638_Board *board, uint32_t matrix);
+
+#ifndef TM1638_NO_HAL
 /**
  * @brief Waits for a single key press and returns its number.
  *
@@ -126,5 +725,214 @@ uint8_t tm1638_scan_buttons(TM1638 *tm);
  *         Returns 0 if multiple keys were pressed simultaneously.
  */
 uint8_t tm1638_read_key_blocking(TM1638 *tm);
+#endif
+
+// --- Multi-Module Bus ---
+
+/**
+ * @brief Initializes a bus of modules that share CLK and DIO.
+ *
+ * With the STM32 transports only modules[0] needs its CLK and DIO pins set;
+ * they are copied to the other handles. Every handle must set its own STB
+ * pin. All modules are then cleared and set to the given brightness with
+ * broadcast commands, i.e. one bus transfer for the whole chain.
+ *
+ * The transport must be synchronous: tm1638_transport_hal,
+ * tm1638_transport_reg or a custom one without send_frame. The SPI and
+ * timer + DMA transports are refused, since their frames are still on the
+ * wire when the call returns and the busy state is kept per handle, so
+ * another module's STB would cut into them.
+ *
+ * @param bus Pointer to the bus object.
+ * @param modules Array of count module handles.
+ * @param count Number of modules on the bus.
+ * @param transport The bus implementation shared by all modules.
+ * @param brightness Initial brightness level (0-7).
+ * @return true on success, false if the transport cannot be shared (the bus
+ *         then has no modules and its functions do nothing).
+ */
+bool tm1638_bus_init(TM1638_Bus *bus, TM1638 *modules, uint8_t count,
+                     const TM1638_Transport *transport, uint8_t brightness);
+
+/**
+ * @brief Sets the brightness of every module with a single broadcast command.
+ * @param bus Pointer to the bus object.
+ * @param brightness The brightness level, from 0 (dimmest) to 7 (brightest).
+ */
+void tm1638_bus_set_brightness(TM1638_Bus *bus, uint8_t brightness);
+
+/**
+ * @brief Clears every module with a single broadcast write.
+ *
+ * Unlike tm1638_display_clear() this is sent immediately; the framebuffers
+ * are updated to match, so a following flush has nothing left to send.
+ *
+ * @param bus Pointer to the bus object.
+ */
+void tm1638_bus_display_clear(TM1638_Bus *bus);
+
+/**
+ * @brief Flushes every module whose framebuffer has pending changes.
+ * @param bus Pointer to the bus object.
+ */
+void tm1638_bus_flush(TM1638_Bus *bus);
+
+// --- Key Events ---
+
+/**
+ * @brief Initializes a key event engine for one module.
+ *
+ * Every key starts with TM1638_DEBOUNCE_MS debouncing and the hold time is
+ * set to TM1638_HOLD_MS.
+ *
+ * @param kp Pointer to the keypad.
+ * @param tm The module to scan.
+ * @param board Key layout (e.g. &tm1638_board_qyf), or NULL for the 8 keys of tm1638_scan_buttons().
+ */
+void tm1638_keypad_init(TM1638_Keypad *kp, TM1638 *tm, const TM1638_Board *board);
+
+/**
+ * @brief Sets the debounce time of one key.
+ * @param kp Pointer to the keypad.
+ * @param key Key number (1 = S1).
+ * @param debounce_ms Time the key must stay stable, in milliseconds.
+ */
+void tm1638_keypad_set_debounce(TM1638_Keypad *kp, uint8_t key, uint8_t debounce_ms);
+
+/**
+ * @brief Enables auto-repeat with acceleration for some keys.
+ *
+ * While such a key is held, TM1638_KEY_REPEAT is sent delay_ms after the
+ * press, then every start_ms; each repeat shortens the interval by 1/8 until
+ * it reaches min_ms.
+ *
+ * @param kp Pointer to the keypad.
+ * @param keys Keys to repeat, bit i for S(i+1) (0 disables auto-repeat).
+ * @param delay_ms Time from the press to the first repeat.
+ * @param start_ms First repeat interval.
+ * @param min_ms Shortest repeat interval.
+ */
+void tm1638_keypad_set_repeat(TM1638_Keypad *kp, uint32_t keys, uint16_t delay_ms,
+                              uint16_t start_ms, uint16_t min_ms);
+
+/**
+ * @brief Watches for a chord, i.e. several keys held down together.
+ *
+ * TM1638_KEY_CHORD is sent once when all keys of the chord are down (other
+ * keys may be down too), and again only after one of them was released. The
+ * PRESS events of the individual keys are still sent.
+ *
+ * @param kp Pointer to the keypad.
+ * @param keys Keys of the chord, bit i for S(i+1) (e.g. S1+S8: 0x81).
+ * @return The chord number reported in the event (1-TM1638_MAX_CHORDS), or 0 if the table is full.
+ */
+uint8_t tm1638_keypad_add_chord(TM1638_Keypad *kp, uint32_t keys);
+
+/**
+ * @brief Scans the keys once and queues the resulting events.
+ *
+ * Non-blocking. Call it regularly, at least once per debounce time (e.g.
+ * every 5 ms from the main loop).
+ *
+ * @param kp Pointer to the keypad.
+ * @param now_ms Current time in milliseconds (e.g. HAL_GetTick()); may wrap around.
+ */
+void tm1638_poll(TM1638_Keypad *kp, uint32_t now_ms);
+
+/**
+ * @brief Feeds an already scanned key state to the engine.
+ *
+ * Same as tm1638_poll() without the bus access, for keys read elsewhere.
+ *
+ * @param kp Pointer to the keypad.
+ * @param keys Bit i set when key S(i+1) is down.
+ * @param now_ms Current time in milliseconds.
+ */
+void tm1638_keypad_update(TM1638_Keypad *kp, uint32_t keys, uint32_t now_ms);
+
+#ifndef TM1638_NO_HAL
+/**
+ * @brief Waits for a key event with the core asleep between scans.
+ *
+ * Scans with tm1638_poll() and sleeps with WFI until the next scan is due
+ * (woken by the HAL tick interrupt). Scans are active_scan_ms apart while
+ * keys are down and for TM1638_ACTIVE_HOLDOFF_MS after, idle_scan_ms apart
+ * otherwise. The awake time is measured with the DWT cycle counter, see
+ * tm1638_wait_duty_permille().
+ *
+ * @param kp Pointer to the keypad; must not be polled from an interrupt at the same time.
+ * @param event Receives the event.
+ * @param timeout_ms Longest wait in milliseconds, HAL_MAX_DELAY to wait forever.
+ * @return true if an event was returned, false on timeout.
+ */
+bool tm1638_wait_event(TM1638_Keypad *kp, TM1638_KeyEvent *event, uint32_t timeout_ms);
+
+/**
+ * @brief Share of the time spent in tm1638_wait_event() the core was awake.
+ *
+ * Computed from the accumulated awake cycles and waiting time; clear both
+ * fields of the keypad to start a new measurement. Reads 1000 when the core
+ * clock keeps running in sleep (e.g. DBGMCU sleep debugging enabled).
+ *
+ * @param kp Pointer to the keypad.
+ * @return The duty cycle in per mille (0-1000).
+ */
+uint16_t tm1638_wait_duty_permille(const TM1638_Keypad *kp);
+#endif
+
+/**
+ * @brief Takes the oldest event from the queue.
+ * @param kp Pointer to the keypad.
+ * @param event Receives the event.
+ * @return true if an event was returned, false if the queue is empty.
+ */
+bool tm1638_get_event(TM1638_Keypad *kp, TM1638_KeyEvent *event);
+
+#ifndef TM1638_NO_HAL
+// --- Parallel Modules ---
+
+/**
+ * @brief Initializes a group of modules driven in parallel on one GPIO port.
+ *
+ * Each handle must set the shared CLK pin, its own DIO pin and its STB pin.
+ * The handles use the register transport, so with one STB line per module
+ * they can still be used on their own (e.g. for tm1638_scan_buttons()).
+ * With a shared STB line only the group functions may be used.
+ *
+ * A group whose CLK, DIO and STB pins are not all on one port, or whose CLK
+ * pin differs between modules, is refused: driving such modules one by one
+ * would clock garbage into the others through the shared lines.
+ *
+ * @param par Pointer to the parallel group.
+ * @param modules Array of count module handles.
+ * @param count Number of modules (1 to TM1638_PARALLEL_MAX_MODULES).
+ * @param brightness Initial brightness level (0-7).
+ * @return true on success, false if count is out of range or the pins do
+ *         not share one port (the group then has no modules and its
+ *         functions do nothing).
+ */
+bool tm1638_parallel_init(TM1638_Parallel *par, TM1638 *modules, uint8_t count, uint8_t brightness);
+
+/**
+ * @brief Flushes all modules of the group in one pass.
+ *
+ * The registers spanning every module's pending changes are sent as one
+ * auto-increment burst, eight clocks per byte for the whole group.
+ *
+ * @param par Pointer to the parallel group.
+ */
+void tm1638_parallel_flush(TM1638_Parallel *par);
+
+/**
+ * @brief Sets the brightness of every module of the group with one command.
+ * @param par Pointer to the parallel group.
+ * @param brightness The brightness level, from 0 (dimmest) to 7 (brightest).
+ */
+void tm1638_parallel_set_brightness(TM1638_Parallel *par, uint8_t brightness);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* TM1638_H_ */
\ No newline at end of file
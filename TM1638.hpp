@@ -0,0 +1,273 @@
+/**
+ * @file TM1638.hpp
+ * @brief C++ helpers for the TM1638 driver.
+ *
+ * Provides a constexpr encoder that turns a string literal into the 8
+ * segment codes tm1638_display_txt() would produce, so fixed labels cost
+ * no parsing or glyph lookup at runtime, and a class template binding the
+ * module to fixed pins at compile time. Requires C++14.
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+
+#ifndef TM1638_HPP_
+#define TM1638_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "TM1638.h"
+#include "TM1638_font.h"
+
+namespace tm1638 {
+
+/**
+ * @brief Segment codes for the 8 digits, left to right.
+ */
+struct Frame8 {
+    uint8_t segments[8];
+};
+
+namespace detail {
+
+constexpr uint8_t font[128] = TM1638_FONT_INITIALIZER;
+
+constexpr uint8_t glyph(char c) {
+    return (static_cast<uint8_t>(c) < 128) ? font[static_cast<uint8_t>(c)] : 0x00;
+}
+
+} // namespace detail
+
+/**
+ * @brief Encodes a string literal at compile time.
+ *
+ * Follows the same rules as tm1638_display_txt(): right-aligned, dots are
+ * merged into the neighbouring digit and extra characters are truncated from
+ * the left.
+ *
+ * @code
+ * static constexpr tm1638::Frame8 ERR01 = tm1638::encode("Err 01");
+ * tm1638::display(&display, ERR01);
+ * @endcode
+ *
+ * @param str The string literal to encode.
+ * @return The 8 segment codes.
+ */
+template <size_t N>
+constexpr Frame8 encode(const char (&str)[N]) {
+    char display_buf[8] = {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '};
+    bool dots[8] = {false, false, false, false, false, false, false, false};
+    int str_idx = static_cast<int>(N) - 2; // Last character before the terminator
+    int buf_idx = 7;
+    Frame8 frame{};
+
+    // Parse the string backwards to handle right-alignment and dots easily
+    while (str_idx >= 0 && buf_idx >= 0) {
+        if (str[str_idx] == '.') {
+            if (buf_idx < 7) {
+                dots[buf_idx + 1] = true;
+            }
+        } else {
+            display_buf[buf_idx] = str[str_idx];
+            buf_idx--;
+        }
+        str_idx--;
+    }
+
+    for (int i = 0; i < 8; i++) {
+        frame.segments[i] = static_cast<uint8_t>(detail::glyph(display_buf[i]) | (dots[i] ? 0x80 : 0x00));
+    }
+    return frame;
+}
+
+/**
+ * @brief Shows a prebuilt frame (framebuffer only; call tm1638_flush()).
+ * @param tm Pointer to the TM1638 handle.
+ * @param frame Segment codes produced by encode().
+ */
+inline void display(TM1638 *tm, const Frame8 &frame) {
+    tm1638_display_raw8(tm, frame.segments);
+}
+
+#ifndef TM1638_NO_HAL
+/**
+ * @brief A TM1638 module on pins fixed at compile time.
+ *
+ * The ports are given by their base address (e.g. GPIOA_BASE) and the pins by
+ * their number (0-15). Every pin edge then compiles to one store of a constant
+ * to a constant BSRR address and the bit loops are fully unrolled, with no
+ * handle fields to load. Only the pin access differs from the register
+ * transport: command framing and flushing are done by the C driver, and
+ * tm1638_set_timing() stretches the CLK phases the same way, so the bus
+ * traffic is identical.
+ *
+ * The object holds a complete TM1638 handle for the C API, so it takes the
+ * same RAM as one (with TM1638_ENABLE_TIM_DMA, including the waveform
+ * buffer); only the bit-level code gets faster.
+ *
+ * @code
+ * static tm1638::Display<GPIOA_BASE, 0, GPIOA_BASE, 1, GPIOA_BASE, 2> panel;
+ * panel.init(7);
+ * panel.display_txt("12.34");
+ * panel.flush();
+ * @endcode
+ */
+template <uintptr_t ClkPort, uint8_t ClkPin,
+          uintptr_t DioPort, uint8_t DioPin,
+          uintptr_t StbPort, uint8_t StbPin>
+class Display {
+public:
+    /**
+     * @brief Bus implementation for these pins, usable with the C API directly.
+     */
+    static const TM1638_Transport transport;
+
+    /**
+     * @brief Initializes the module (pins must already be outputs, as for tm1638_init()).
+     * @param brightness Initial brightness level (0-7).
+     */
+    void init(uint8_t brightness) {
+        tm_.clk_port = clk();
+        tm_.clk_pin = CLK_MASK;
+        tm_.dio_port = dio();
+        tm_.dio_pin = DIO_MASK;
+        tm_.stb_port = stb();
+        tm_.stb_pin = STB_MASK;
+        tm1638_init_transport(&tm_, &transport, brightness);
+    }
+
+    /**
+     * @brief The underlying C handle, for the rest of the C API.
+     */
+    TM1638 *handle() { return &tm_; }
+
+    void set_brightness(uint8_t brightness) { tm1638_set_brightness(&tm_, brightness); }
+    void display_clear() { tm1638_display_clear(&tm_); }
+    void display_char(uint8_t position, char c, bool dot) { tm1638_display_char(&tm_, position, c, dot); }
+    void display_txt(const char *str) { tm1638_display_txt(&tm_, str); }
+    void display(const Frame8 &frame) { tm1638_display_raw8(&tm_, frame.segments); }
+    void set_led(uint8_t position, bool on) { tm1638_set_led(&tm_, position, on); }
+    void set_segment(uint8_t position, uint8_t data) { tm1638_set_segment(&tm_, position, data); }
+    void flush() { tm1638_flush(&tm_); }
+    uint8_t scan_buttons() { return tm1638_scan_buttons(&tm_); }
+    uint32_t scan_matrix() { return tm1638_scan_matrix(&tm_); }
+
+private:
+    static_assert(ClkPin < 16 && DioPin < 16 && StbPin < 16, "TM1638 pin numbers must be 0-15");
+
+    static const uint32_t CLK_MASK = 1UL << ClkPin;
+    static const uint32_t DIO_MASK = 1UL << DioPin;
+    static const uint32_t STB_MASK = 1UL << StbPin;
+    static const uint32_t DIO_MODER_MASK = 0x3UL << (2 * DioPin);
+    static const uint32_t DIO_MODER_OUTPUT = 0x1UL << (2 * DioPin);
+
+    static GPIO_TypeDef *clk() { return reinterpret_cast<GPIO_TypeDef *>(ClkPort); }
+    static GPIO_TypeDef *dio() { return reinterpret_cast<GPIO_TypeDef *>(DioPort); }
+    static GPIO_TypeDef *stb() { return reinterpret_cast<GPIO_TypeDef *>(StbPort); }
+
+    // Same setup as tm1638_dio_init(), with the masks known at compile time
+    static void pin_init(TM1638 *tm) {
+        tm->dio_moder_mask = DIO_MODER_MASK;
+        tm->dio_moder_output = DIO_MODER_OUTPUT;
+        tm->dio_open_drain = (dio()->OTYPER & DIO_MASK) != 0;
+        dio()->PUPDR = (dio()->PUPDR & ~DIO_MODER_MASK) | (0x1UL << (2 * DioPin));
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        tm->twait_cycles = static_cast<uint16_t>(
+            (static_cast<uint64_t>(TM1638_TWAIT_NS) * SystemCoreClock + 999999999U) / 1000000000U);
+    }
+
+    // Same busy-wait as tm1638_delay_cycles()
+    static void delay_cycles(uint32_t cycles) {
+        if (cycles == 0) {
+            return;
+        }
+        uint32_t start = DWT->CYCCNT;
+        while (static_cast<uint32_t>(DWT->CYCCNT - start) < cycles) {
+        }
+    }
+
+    static void begin(TM1638 *) {
+        stb()->BSRR = STB_MASK << 16;
+    }
+
+    static void end(TM1638 *) {
+        stb()->BSRR = STB_MASK;
+    }
+
+    static inline __attribute__((always_inline)) void write_bit(uint8_t byte, uint8_t bit) {
+        clk()->BSRR = CLK_MASK << 16;
+        dio()->BSRR = ((byte >> bit) & 0x01) ? DIO_MASK : DIO_MASK << 16;
+        clk()->BSRR = CLK_MASK;
+    }
+
+    // Bit loop with the CLK times of tm1638_set_timing(), like tm1638_reg_write_timed()
+    static void write_timed(TM1638 *tm, const uint8_t *data, uint8_t len) {
+        for (uint8_t n = 0; n < len; n++) {
+            uint8_t byte = data[n];
+            for (uint8_t i = 0; i < 8; i++) {
+                clk()->BSRR = CLK_MASK << 16;
+                dio()->BSRR = (byte & 0x01) ? DIO_MASK : DIO_MASK << 16;
+                byte >>= 1;
+                delay_cycles(tm->clk_low_cycles);
+                clk()->BSRR = CLK_MASK;
+                delay_cycles(tm->clk_high_cycles);
+            }
+        }
+    }
+
+    static void write(TM1638 *tm, const uint8_t *data, uint8_t len) {
+        if ((tm->clk_low_cycles | tm->clk_high_cycles) != 0) {
+            write_timed(tm, data, len);
+            return;
+        }
+        for (uint8_t n = 0; n < len; n++) {
+            uint8_t byte = data[n];
+            write_bit(byte, 0);
+            write_bit(byte, 1);
+            write_bit(byte, 2);
+            write_bit(byte, 3);
+            write_bit(byte, 4);
+            write_bit(byte, 5);
+            write_bit(byte, 6);
+            write_bit(byte, 7);
+        }
+    }
+
+    static void read(TM1638 *tm, uint8_t *data, uint8_t len) {
+        if (tm->dio_open_drain) {
+            dio()->BSRR = DIO_MASK; // Release the line
+        } else {
+            dio()->MODER &= ~DIO_MODER_MASK;
+        }
+        delay_cycles(tm->twait_cycles);
+        for (uint8_t n = 0; n < len; n++) {
+            uint8_t byte = 0;
+            for (uint8_t i = 0; i < 8; i++) {
+                clk()->BSRR = CLK_MASK << 16;
+                delay_cycles(tm->clk_low_cycles);
+                if (dio()->IDR & DIO_MASK) {
+                    byte |= (uint8_t)(1U << i);
+                }
+                clk()->BSRR = CLK_MASK;
+                delay_cycles(tm->clk_high_cycles);
+            }
+            data[n] = byte;
+        }
+        if (!tm->dio_open_drain) {
+            dio()->MODER = (dio()->MODER & ~DIO_MODER_MASK) | DIO_MODER_OUTPUT;
+        }
+    }
+
+    TM1638 tm_{};
+};
+
+template <uintptr_t ClkPort, uint8_t ClkPin, uintptr_t DioPort, uint8_t DioPin, uintptr_t StbPort, uint8_t StbPin>
+const TM1638_Transport Display<ClkPort, ClkPin, DioPort, DioPin, StbPort, StbPin>::transport = {
+    pin_init, begin, end, write, read, nullptr, TM1638_STB_CYCLE_COST,
+};
+#endif /* TM1638_NO_HAL */
+
+} // namespace tm1638
+
+#endif /* TM1638_HPP_ */
@@ -0,0 +1,47 @@
+/**
+ * @file TM1638_font.h
+ * @brief 7-segment glyph table shared by the C driver and the C++ helpers.
+ *
+ * 128 entries indexed by ASCII code. Segments are mapped as:
+ * bit 0=A, 1=B, 2=C, 3=D, 4=E, 5=F, 6=G, 7=DP.
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+
+#ifndef TM1638_FONT_H_
+#define TM1638_FONT_H_
+
+#define TM1638_FONT_INITIALIZER { \
+    /* 0x00-0x1F: control characters */ \
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
+    /* ' '   '!'   '"'   '#'   '$'   '%'   '&'   ''' */ \
+    0x00, 0x86, 0x22, 0x7e, 0x6d, 0xd2, 0x46, 0x20, \
+    /* '('   ')'   '*'   '+'   ','   '-'   '.'   '/' */ \
+    0x29, 0x0b, 0x21, 0x70, 0x10, 0x40, 0x80, 0x52, \
+    /* '0'   '1'   '2'   '3'   '4'   '5'   '6'   '7' */ \
+    0x3f, 0x06, 0x5b, 0x4f, 0x66, 0x6d, 0x7d, 0x07, \
+    /* '8'   '9'   ':'   ';'   '<'   '='   '>'   '?' */ \
+    0x7f, 0x6f, 0x09, 0x0d, 0x61, 0x48, 0x43, 0xd3, \
+    /* '@'   'A'   'B'   'C'   'D'   'E'   'F'   'G' */ \
+    0x5f, 0x77, 0x7f, 0x39, 0x3f, 0x79, 0x71, 0x7d, \
+    /* 'H'   'I'   'J'   'K'   'L'   'M'   'N'   'O' */ \
+    0x76, 0x06, 0x0e, 0x75, 0x38, 0x15, 0x37, 0x3f, \
+    /* 'P'   'Q'   'R'   'S'   'T'   'U'   'V'   'W' */ \
+    0x73, 0x6b, 0x33, 0x6d, 0x78, 0x3e, 0x3e, 0x2a, \
+    /* 'X'   'Y'   'Z'   '['   '\'  ']'   '^'   '_' */ \
+    0x76, 0x6e, 0x5b, 0x39, 0x64, 0x0f, 0x23, 0x08, \
+    /* '`'   'a'   'b'   'c'   'd'   'e'   'f'   'g' */ \
+    0x02, 0x5f, 0x7c, 0x58, 0x5e, 0x7b, 0x71, 0x6f, \
+    /* 'h'   'i'   'j'   'k'   'l'   'm'   'n'   'o' */ \
+    0x74, 0x04, 0x0c, 0x75, 0x30, 0x14, 0x54, 0x5c, \
+    /* 'p'   'q'   'r'   's'   't'   'u'   'v'   'w' */ \
+    0x73, 0x67, 0x50, 0x6d, 0x78, 0x1c, 0x1c, 0x14, \
+    /* 'x'   'y'   'z'   '{'   '|'   '}'   '~'   DEL */ \
+    0x76, 0x6e, 0x5b, 0x46, 0x06, 0x70, 0x01, 0x00, \
+}
+
+#endif /* TM1638_FONT_H_ */
@@ -0,0 +1,336 @@
+/**
+ * @file TM1638_sim.c
+ * @brief Host-side model of the TM1638 chip.
+ *
+ * Decodes the serial protocol edge by edge and applies the commands to a
+ * copy of the chip state, so the driver's bus traffic can be checked
+ * without hardware.
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+#include "TM1638_sim.h"
+#include <string.h>
+
+// --- Private Function Prototypes ---
+
+static void tm1638_sim_byte(TM1638_Sim *sim, uint8_t byte);
+static void tm1638_sim_decode(TM1638_Sim *sim, bool clk, bool dio, bool stb);
+
+static void tm1638_sim_begin(TM1638 *tm);
+static void tm1638_sim_end(TM1638 *tm);
+static void tm1638_sim_write(TM1638 *tm, const uint8_t *data, uint8_t len);
+static void tm1638_sim_read(TM1638 *tm, uint8_t *data, uint8_t len);
+
+// --- Public Function Implementation ---
+
+/**
+ * @brief Puts the model in its power-up state.
+ * @param sim Pointer to the model.
+ */
+void tm1638_sim_init(TM1638_Sim *sim) {
+    memset(sim, 0, sizeof(*sim));
+    sim->clk = true;
+    sim->dio = true;
+    sim->stb = true;
+    sim->dio_out = true;
+    sim->step_ns = TM1638_SIM_STEP_NS;
+}
+
+/**
+ * @brief Initializes a driver handle with the model as bus.
+ * @param tm Pointer to the TM1638 handle.
+ * @param sim Pointer to an initialized model.
+ * @param brightness Initial brightness level (0-7).
+ */
+void tm1638_sim_attach(TM1638 *tm, TM1638_Sim *sim, uint8_t brightness) {
+    tm->transport_ctx = sim;
+    tm1638_init_transport(tm, &tm1638_transport_sim, brightness);
+}
+
+/**
+ * @brief Applies the levels the MCU drives and decodes any resulting edges.
+ * @param sim Pointer to the model.
+ * @param clk CLK level.
+ * @param dio DIO level driven by the MCU.
+ * @param stb STB level.
+ */
+void tm1638_sim_pins(TM1638_Sim *sim, bool clk, bool dio, bool stb) {
+    bool old_clk = sim->clk;
+    bool old_dio = tm1638_sim_dio(sim);
+    bool old_stb = sim->stb;
+    bool line;
+
+    sim->time_ns += sim->step_ns;
+    sim->gpio_calls++;
+    if (!stb && !old_stb && clk && !old_clk) {
+        sim->bits++;
+    }
+    if (!stb && old_stb) {
+        sim->frames++;
+    }
+    tm1638_sim_decode(sim, clk, dio, stb);
+    line = tm1638_sim_dio(sim);
+
+    sim->edges += (uint32_t)(clk != old_clk) + (uint32_t)(line != old_dio) + (uint32_t)(stb != old_stb);
+    if (sim->vcd != NULL && (clk != old_clk || line != old_dio || stb != old_stb)) {
+        fprintf(sim->vcd, "#%llu\n", (unsigned long long)sim->time_ns);
+        if (clk != old_clk) {
+            fprintf(sim->vcd, "%dc\n", clk ? 1 : 0);
+        }
+        if (line != old_dio) {
+            fprintf(sim->vcd, "%dd\n", line ? 1 : 0);
+        }
+        if (stb != old_stb) {
+            fprintf(sim->vcd, "%ds\n", stb ? 1 : 0);
+        }
+    }
+}
+
+/**
+ * @brief Level of the DIO line.
+ * @param sim Pointer to the model.
+ * @return true if the line is high.
+ */
+bool tm1638_sim_dio(const TM1638_Sim *sim) {
+    // Open-drain wired AND: either side can pull the line low
+    return sim->dio && sim->dio_out;
+}
+
+/**
+ * @brief Starts recording the lines as a VCD file.
+ * @param sim Pointer to the model.
+ * @param out File opened for writing.
+ * @param step_ns Virtual time per tm1638_sim_pins() call, 0 if the caller sets time_ns.
+ */
+void tm1638_sim_vcd_open(TM1638_Sim *sim, FILE *out, uint32_t step_ns) {
+    sim->vcd = out;
+    sim->step_ns = step_ns;
+    fprintf(out, "$timescale 1ns $end\n"
+                 "$scope module tm1638 $end\n"
+                 "$var wire 1 c CLK $end\n"
+                 "$var wire 1 d DIO $end\n"
+                 "$var wire 1 s STB $end\n"
+                 "$upscope $end\n"
+                 "$enddefinitions $end\n");
+    fprintf(out, "#%llu\n$dumpvars\n%dc\n%dd\n%ds\n$end\n", (unsigned long long)sim->time_ns,
+            sim->clk ? 1 : 0, tm1638_sim_dio(sim) ? 1 : 0, sim->stb ? 1 : 0);
+}
+
+/**
+ * @brief Stops recording.
+ * @param sim Pointer to the model.
+ */
+void tm1638_sim_vcd_close(TM1638_Sim *sim) {
+    if (sim->vcd == NULL) {
+        return;
+    }
+    fprintf(sim->vcd, "#%llu\n", (unsigned long long)(sim->time_ns + (sim->step_ns ? sim->step_ns : 1U)));
+    fflush(sim->vcd);
+    sim->vcd = NULL;
+}
+
+/**
+ * @brief Clears the bus cost counters.
+ * @param sim Pointer to the model.
+ */
+void tm1638_sim_reset_counters(TM1638_Sim *sim) {
+    sim->edges = 0;
+    sim->bits = 0;
+    sim->frames = 0;
+    sim->gpio_calls = 0;
+}
+
+/**
+ * @brief Estimated bus time of the counted GPIO writes.
+ * @param sim Pointer to the model.
+ * @param toggle_ns Time of one GPIO write on the target.
+ * @return gpio_calls * toggle_ns, in microseconds.
+ */
+double tm1638_sim_estimate_us(const TM1638_Sim *sim, uint32_t toggle_ns) {
+    return (double)sim->gpio_calls * toggle_ns / 1000.0;
+}
+
+/**
+ * @brief Sets which keys are down.
+ * @param sim Pointer to the model.
+ * @param matrix Key matrix in the tm1638_scan_matrix() layout.
+ */
+void tm1638_sim_set_keys(TM1638_Sim *sim, uint32_t matrix) {
+    // Bits 3 and 7 of every key byte always read as 0
+    sim->keys = matrix & 0x77777777UL;
+}
+
+/**
+ * @brief Segment code shown on a digit.
+ * @param sim Pointer to the model.
+ * @param position Digit position (1-8).
+ * @return The segment byte, 0 for an invalid position.
+ */
+uint8_t tm1638_sim_segment(const TM1638_Sim *sim, uint8_t position) {
+    if (position < 1 || position > 8) {
+        return 0;
+    }
+    return sim->ram[(position - 1) * 2];
+}
+
+/**
+ * @brief State of an LED.
+ * @param sim Pointer to the model.
+ * @param position LED position (1-8).
+ * @return true if the LED is lit.
+ */
+bool tm1638_sim_led(const TM1638_Sim *sim, uint8_t position) {
+    if (position < 1 || position > 8) {
+        return false;
+    }
+    return (sim->ram[(position - 1) * 2 + 1] & 0x01) != 0;
+}
+
+// --- Private Helper Function Implementation ---
+
+/**
+ * @brief Updates the line levels and runs the protocol decoder on their edges.
+ * @param sim Pointer to the model.
+ * @param clk CLK level.
+ * @param dio DIO level driven by the MCU.
+ * @param stb STB level.
+ */
+static void tm1638_sim_decode(TM1638_Sim *sim, bool clk, bool dio, bool stb) {
+    bool clk_rise = clk && !sim->clk;
+    bool clk_fall = !clk && sim->clk;
+
+    if (stb != sim->stb) {
+        // Either edge of STB ends the frame; falling starts a new one with a command byte
+        sim->bit_count = 0;
+        sim->byte_count = 0;
+        sim->reading = false;
+        sim->dio_out = true;
+    }
+    sim->clk = clk;
+    sim->dio = dio;
+    sim->stb = stb;
+    if (stb) {
+        return; // Chip not selected
+    }
+
+    if (sim->reading) {
+        // Key data: the chip presents the next bit after each falling CLK edge
+        if (clk_fall) {
+            if (sim->read_bit == 0 && sim->time_ns - sim->read_cmd_ns < TM1638_SIM_TWAIT_NS) {
+                sim->twait_errors++;
+            }
+            sim->dio_out = (sim->read_bit < 32) ? ((sim->keys >> sim->read_bit) & 1U) != 0 : true;
+            sim->read_bit++;
+        }
+        return;
+    }
+
+    if (clk_rise) {
+        sim->shift |= (uint8_t)((dio ? 1U : 0U) << sim->bit_count);
+        if (++sim->bit_count == 8) {
+            tm1638_sim_byte(sim, sim->shift);
+            sim->shift = 0;
+            sim->bit_count = 0;
+        }
+    }
+}
+
+/**
+ * @brief Applies a received byte: the first of a frame is a command, the rest data.
+ * @param sim Pointer to the model.
+ * @param byte The received byte.
+ */
+static void tm1638_sim_byte(TM1638_Sim *sim, uint8_t byte) {
+    if (sim->byte_count++ == 0) {
+        sim->command = byte;
+        switch (byte & 0xC0) {
+        case 0x40: // Data command
+            if ((byte & 0x03) == 0x02) {
+                sim->reading = true;
+                sim->read_bit = 0;
+                sim->read_cmd_ns = sim->time_ns;
+            } else if ((byte & 0x03) == 0x00) {
+                sim->fixed_address = (byte & 0x04) != 0;
+            } else {
+                sim->errors++;
+            }
+            break;
+        case 0x80: // Display control
+            sim->display_on = (byte & 0x08) != 0;
+            sim->brightness = byte & 0x07;
+            break;
+        case 0xC0: // Address command
+            sim->address = byte & 0x0F;
+            break;
+        default:
+            sim->errors++;
+            break;
+        }
+        return;
+    }
+
+    // Only an address command may be followed by data
+    if ((sim->command & 0xC0) != 0xC0) {
+        sim->errors++;
+        return;
+    }
+    sim->ram[sim->address] = byte;
+    if (!sim->fixed_address) {
+        sim->address = (sim->address + 1) & 0x0F;
+    }
+}
+
+// --- Simulator Transport ---
+
+// Bit-banged like the HAL transport: one pin change per call, CLK low / DIO / CLK high per bit
+
+static void tm1638_sim_begin(TM1638 *tm) {
+    TM1638_Sim *sim = (TM1638_Sim *)tm->transport_ctx;
+    tm1638_sim_pins(sim, sim->clk, sim->dio, false);
+}
+
+static void tm1638_sim_end(TM1638 *tm) {
+    TM1638_Sim *sim = (TM1638_Sim *)tm->transport_ctx;
+    tm1638_sim_pins(sim, sim->clk, sim->dio, true);
+}
+
+static void tm1638_sim_write(TM1638 *tm, const uint8_t *data, uint8_t len) {
+    TM1638_Sim *sim = (TM1638_Sim *)tm->transport_ctx;
+    for (uint8_t n = 0; n < len; n++) {
+        uint8_t byte = data[n];
+        for (uint8_t i = 0; i < 8; i++) {
+            tm1638_sim_pins(sim, false, sim->dio, false);
+            tm1638_sim_pins(sim, false, (byte & 0x01) != 0, false);
+            byte >>= 1;
+            tm1638_sim_pins(sim, true, sim->dio, false);
+        }
+    }
+}
+
+static void tm1638_sim_read(TM1638 *tm, uint8_t *data, uint8_t len) {
+    TM1638_Sim *sim = (TM1638_Sim *)tm->transport_ctx;
+    tm1638_sim_pins(sim, sim->clk, true, false); // Release DIO
+    sim->time_ns += TM1638_SIM_TWAIT_NS;
+    for (uint8_t n = 0; n < len; n++) {
+        uint8_t byte = 0;
+        for (uint8_t i = 0; i < 8; i++) {
+            tm1638_sim_pins(sim, false, true, false);
+            if (tm1638_sim_dio(sim)) {
+                byte |= (uint8_t)(1U << i);
+            }
+            tm1638_sim_pins(sim, true, true, false);
+        }
+        data[n] = byte;
+    }
+}
+
+const TM1638_Transport tm1638_transport_sim = {
+    .init = NULL,
+    .begin = tm1638_sim_begin,
+    .end = tm1638_sim_end,
+    .write = tm1638_sim_write,
+    .read = tm1638_sim_read,
+    .send_frame = NULL,
+    .stb_cycle_cost = TM1638_STB_CYCLE_COST,
+};
@@ -0,0 +1,199 @@
+/**
+ * @file TM1638_sim.h
+ * @brief Host-side model of the TM1638 chip for testing the driver without a board.
+ *
+ * The model decodes CLK, DIO and STB edges the way the datasheet describes
+ * and keeps the chip state: display RAM, display control and a key matrix
+ * that tests can press keys in. It is driven either pin by pin with
+ * tm1638_sim_pins() or through tm1638_transport_sim. The mock HAL in host/
+ * calls tm1638_sim_pins() on every GPIO register access, so the STM32
+ * transports of TM1638.c run against it unchanged; tm1638_transport_sim
+ * needs no HAL and also builds with TM1638_NO_HAL.
+ *
+ * Every pin change can also be written to a VCD file (GTKWave, PulseView)
+ * on a virtual time base of one step per tm1638_sim_pins() call.
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+
+#ifndef TM1638_SIM_H_
+#define TM1638_SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "TM1638.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Default virtual time per tm1638_sim_pins() call, i.e. per GPIO write (ns). */
+#ifndef TM1638_SIM_STEP_NS
+#define TM1638_SIM_STEP_NS 100
+#endif
+
+/** @brief Twait: shortest time from the read command to the first key data clock (ns). */
+#ifndef TM1638_SIM_TWAIT_NS
+#define TM1638_SIM_TWAIT_NS 1000
+#endif
+
+/**
+ * @brief State of one simulated TM1638.
+ */
+typedef struct {
+    // Display registers, display on/off and brightness (0-7) as the chip holds them
+    uint8_t ram[16];
+    bool display_on;
+    uint8_t brightness;
+
+    // Key matrix reported to reads, in the tm1638_scan_matrix() layout
+    uint32_t keys;
+
+    // Line levels driven by the MCU (DIO: true also when released)
+    bool clk, dio, stb;
+
+    // DIO level driven by the chip: false while it pulls the line low
+    bool dio_out;
+
+    // Serial decoder: bits shifted in, bytes since STB went low, first byte of the frame
+    uint8_t shift;
+    uint8_t bit_count;
+    uint8_t byte_count;
+    uint8_t command;
+
+    // Address pointer and addressing mode of the last data command
+    uint8_t address;
+    bool fixed_address;
+
+    // Set after a read command; next key bit to shift out
+    bool reading;
+    uint8_t read_bit;
+
+    // Time the read command was taken, and reads clocked less than
+    // TM1638_SIM_TWAIT_NS after it (the chip had no key data ready yet)
+    uint64_t read_cmd_ns;
+    uint32_t twait_errors;
+
+    // Frames the chip would not accept (unknown command, data without address command)
+    uint32_t errors;
+
+    // Virtual time, advanced by step_ns on every tm1638_sim_pins() call
+    uint64_t time_ns;
+    uint32_t step_ns;
+
+    // Bus cost counters, cleared by tm1638_sim_reset_counters(): level changes of
+    // CLK, DIO (line level) and STB, bits clocked while selected, STB low
+    // periods (frames) and tm1638_sim_pins() calls (GPIO writes)
+    uint32_t edges;
+    uint32_t bits;
+    uint32_t frames;
+    uint32_t gpio_calls;
+
+    // VCD output, NULL when not recording
+    FILE *vcd;
+} TM1638_Sim;
+
+/** @brief Transport clocking a TM1638_Sim attached with tm1638_sim_attach(). */
+extern const TM1638_Transport tm1638_transport_sim;
+
+/**
+ * @brief Puts the model in its power-up state: RAM cleared, display off, no key down.
+ * @param sim Pointer to the model.
+ */
+void tm1638_sim_init(TM1638_Sim *sim);
+
+/**
+ * @brief Initializes a driver handle on tm1638_transport_sim with the model as bus.
+ * @param tm Pointer to the TM1638 handle.
+ * @param sim Pointer to an initialized model.
+ * @param brightness Initial brightness level (0-7).
+ */
+void tm1638_sim_attach(TM1638 *tm, TM1638_Sim *sim, uint8_t brightness);
+
+/**
+ * @brief Applies the levels the MCU drives and decodes any resulting edges.
+ *
+ * Data is taken on the rising CLK edge, LSB first; key data is shifted out
+ * on the falling edge. STB high ends the frame.
+ *
+ * @param sim Pointer to the model.
+ * @param clk CLK level.
+ * @param dio DIO level driven by the MCU (true when released for reading).
+ * @param stb STB level.
+ */
+void tm1638_sim_pins(TM1638_Sim *sim, bool clk, bool dio, bool stb);
+
+/**
+ * @brief Level of the DIO line: the pull-up, the MCU and the chip combined.
+ * @param sim Pointer to the model.
+ * @return true if the line is high.
+ */
+bool tm1638_sim_dio(const TM1638_Sim *sim);
+
+/**
+ * @brief Starts recording the CLK, DIO and STB lines as a VCD file.
+ *
+ * Writes the header and the current levels at the current virtual time.
+ * The file stays owned by the caller. With a step_ns of 0 the time stamps
+ * come from time_ns as set by the caller, e.g. the host mock HAL's clock.
+ *
+ * @param sim Pointer to the model.
+ * @param out File opened for writing.
+ * @param step_ns Virtual time per tm1638_sim_pins() call, i.e. the GPIO write period (0: caller's time).
+ */
+void tm1638_sim_vcd_open(TM1638_Sim *sim, FILE *out, uint32_t step_ns);
+
+/**
+ * @brief Stops recording, after a last time stamp so the final levels show in viewers.
+ * @param sim Pointer to the model.
+ */
+void tm1638_sim_vcd_close(TM1638_Sim *sim);
+
+/**
+ * @brief Clears the bus cost counters (edges, bits, frames, gpio_calls).
+ *
+ * Call it before a driver function to measure what that call costs on the
+ * bus; the virtual time is not reset, so VCD recordings stay continuous.
+ *
+ * @param sim Pointer to the model.
+ */
+void tm1638_sim_reset_counters(TM1638_Sim *sim);
+
+/**
+ * @brief Estimated bus time of the counted GPIO writes.
+ * @param sim Pointer to the model.
+ * @param toggle_ns Time of one GPIO write on the target (e.g. 12 ns for BSRR at 84 MHz).
+ * @return gpio_calls * toggle_ns, in microseconds.
+ */
+double tm1638_sim_estimate_us(const TM1638_Sim *sim, uint32_t toggle_ns);
+
+/**
+ * @brief Sets which keys are down.
+ * @param sim Pointer to the model.
+ * @param matrix Key matrix in the tm1638_scan_matrix() layout (e.g. S1 of LED&KEY: 1UL << 1).
+ */
+void tm1638_sim_set_keys(TM1638_Sim *sim, uint32_t matrix);
+
+/**
+ * @brief Segment code shown on a digit.
+ * @param sim Pointer to the model.
+ * @param position Digit position (1-8).
+ * @return The segment byte, 0 for an invalid position.
+ */
+uint8_t tm1638_sim_segment(const TM1638_Sim *sim, uint8_t position);
+
+/**
+ * @brief State of an LED.
+ * @param sim Pointer to the model.
+ * @param position LED position (1-8).
+ * @return true if the LED is lit.
+ */
+bool tm1638_sim_led(const TM1638_Sim *sim, uint8_t position);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TM1638_SIM_H_ */
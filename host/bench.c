@@ -0,0 +1,483 @@
+/**
+ * @file bench.c
+ * @brief Bus cost and cycles of each public call, the baseline for performance changes.
+ *
+ * Every case repeats one call BENCH_RUNS times, with an unmeasured prepare
+ * step before each run so the call always has the same work to do (e.g. new
+ * digits for tm1638_display_txt()), and reports the average cycles read with
+ * TM1638_CYCLES() and the time they take at SystemCoreClock.
+ *
+ * Host: built against the mock HAL (make -C host bench), the suite runs once
+ * per transport. The cycles are the mock's virtual clock, so they model the
+ * GPIO traffic rather than the core; the model connected to the pins adds the
+ * clocked bits, STB frames and GPIO writes it decoded, plus the register
+ * accesses of the mock.
+ *
+ * Target: add this file to the firmware and call tm1638_bench() on an
+ * initialized handle with printf() retargeted (SWO or UART). The cycles are
+ * then DWT->CYCCNT, enabled by the init functions.
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include "TM1638.h"
+#include "TM1638_font.h"
+#ifdef TM1638_HOST_MOCK
+#include <time.h>
+#include "TM1638_sim.h"
+#include "tm1638_mock.h"
+#endif
+
+/** @brief Measured runs per case. */
+#ifndef BENCH_RUNS
+#define BENCH_RUNS 100
+#endif
+
+#ifndef TM1638_CYCLES
+#ifdef TM1638_HOST_MOCK
+#define TM1638_CYCLES() tm1638_mock_cycles()
+#else
+#define TM1638_CYCLES() (DWT->CYCCNT)
+#endif
+#endif
+
+/** @brief Passes over the printable characters per glyph lookup measurement. */
+#ifndef BENCH_GLYPH_RUNS
+#define BENCH_GLYPH_RUNS 1000
+#endif
+
+/*
+ * Code that does not touch the bus is timed on the CPU running it: host
+ * nanoseconds under the mock, whose virtual clock only counts GPIO traffic,
+ * and core cycles on target.
+ */
+#ifdef TM1638_HOST_MOCK
+#define BENCH_CPU_UNIT "host ns"
+static uint32_t bench_cpu_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+#else
+#define BENCH_CPU_UNIT "cycles"
+#define bench_cpu_now() TM1638_CYCLES()
+#endif
+
+void tm1638_bench(TM1638 *tm);
+
+/** @brief One call under test. */
+typedef struct {
+    const char *name;
+    void (*prepare)(TM1638 *tm); // Not measured, may be NULL
+    void (*call)(TM1638 *tm);
+} BenchCase;
+
+#ifdef TM1638_HOST_MOCK
+/** @brief Model on the bench handle's pins, NULL on target. */
+static TM1638_Sim *bench_sim;
+#endif
+
+static TM1638_Keypad bench_keypad;
+static uint32_t bench_now_ms;
+
+// --- Cases ---
+
+static void prep_blank(TM1638 *tm) {
+    tm1638_display_txt(tm, "        ");
+    tm1638_flush(tm);
+}
+
+static void prep_lit(TM1638 *tm) {
+    tm1638_display_txt(tm, "88888888");
+    tm1638_flush(tm);
+}
+
+static void prep_led_off(TM1638 *tm) {
+    tm1638_set_led(tm, 1, false);
+    tm1638_flush(tm);
+}
+
+static void prep_dim(TM1638 *tm) {
+    tm1638_set_brightness(tm, 2);
+}
+
+static void call_display_txt(TM1638 *tm) {
+    tm1638_display_txt(tm, "12345678");
+    tm1638_flush(tm);
+}
+
+static void call_display_char(TM1638 *tm) {
+    tm1638_display_char(tm, 1, 'A', true);
+    tm1638_flush(tm);
+}
+
+static void call_set_segment(TM1638 *tm) {
+    tm1638_set_segment(tm, 1, 0x7F);
+    tm1638_flush(tm);
+}
+
+static void call_display_raw8(TM1638 *tm) {
+    static const uint8_t segments[8] = {0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F};
+    tm1638_display_raw8(tm, segments);
+    tm1638_flush(tm);
+}
+
+static void call_display_clear(TM1638 *tm) {
+    tm1638_display_clear(tm);
+    tm1638_flush(tm);
+}
+
+static void call_set_led(TM1638 *tm) {
+    tm1638_set_led(tm, 1, true);
+    tm1638_flush(tm);
+}
+
+static void call_set_brightness(TM1638 *tm) {
+    tm1638_set_brightness(tm, 7);
+}
+
+static void call_flush(TM1638 *tm) {
+    tm1638_flush(tm);
+}
+
+static void call_scan_buttons(TM1638 *tm) {
+    (void)tm1638_scan_buttons(tm);
+}
+
+static void call_scan_matrix(TM1638 *tm) {
+    (void)tm1638_scan_matrix(tm);
+}
+
+static void call_poll(TM1638 *tm) {
+    (void)tm;
+    bench_now_ms += 10;
+    tm1638_poll(&bench_keypad, bench_now_ms);
+}
+
+static const BenchCase bench_cases[] = {
+    {"tm1638_display_txt (8 new digits) + flush", prep_blank, call_display_txt},
+    {"tm1638_display_char + flush", prep_blank, call_display_char},
+    {"tm1638_set_segment + flush", prep_blank, call_set_segment},
+    {"tm1638_display_raw8 + flush", prep_blank, call_display_raw8},
+    {"tm1638_display_clear + flush (8 digits lit)", prep_lit, call_display_clear},
+    {"tm1638_set_led + flush", prep_led_off, call_set_led},
+    {"tm1638_set_brightness", prep_dim, call_set_brightness},
+    {"tm1638_flush (nothing pending)", NULL, call_flush},
+    {"tm1638_scan_buttons", NULL, call_scan_buttons},
+    {"tm1638_scan_matrix", NULL, call_scan_matrix},
+    {"tm1638_poll (no change)", NULL, call_poll},
+};
+
+// --- Glyph lookup ---
+
+/**
+ * @brief The switch char_to_segment_code() used before the font table, as reference.
+ */
+static uint8_t bench_switch_glyph(char c) {
+    switch (c) {
+        // Digits
+        case '0': return 0x3f;
+        case '1': return 0x06;
+        case '2': return 0x5b;
+        case '3': return 0x4f;
+        case '4': return 0x66;
+        case '5': return 0x6d;
+        case '6': return 0x7d;
+        case '7': return 0x07;
+        case '8': return 0x7f;
+        case '9': return 0x6f;
+        // Letters (uppercase)
+        case 'A': return 0x77;
+        case 'B': return 0x7f; // Same as '8'
+        case 'C': return 0x39;
+        case 'D': return 0x3f;
+        case 'E': return 0x79;
+        case 'F': return 0x71;
+        case 'G': return 0x7d;
+        case 'H': return 0x76;
+        case 'I': return 0x06; // Same as '1'
+        case 'J': return 0x0e;
+        case 'L': return 0x38;
+        case 'O': return 0x3f; // Same as '0'
+        case 'P': return 0x73;
+        case 'S': return 0x6d; // Same as '5'
+        case 'U': return 0x3e;
+        // Letters (lowercase)
+        case 'a': return 0x5f;
+        case 'b': return 0x7c;
+        case 'c': return 0x58;
+        case 'd': return 0x5e;
+        case 'f': return 0x71;
+        case 'g': return 0x6f;
+        case 'h': return 0x74;
+        case 'i': return 0x04;
+        case 'n': return 0x54;
+        case 'o': return 0x5c;
+        case 'r': return 0x50;
+        case 't': return 0x78;
+        case 'u': return 0x1c;
+        case 'y': return 0x6e;
+        // Symbols
+        case ' ': return 0x00;
+        case '_': return 0x08;
+        case '-': return 0x40;
+        default:  return 0x00; // Blank for unsupported characters
+    }
+}
+
+/** @brief The driver's font table, as compiled into TM1638.c. */
+static const uint8_t bench_font[128] = TM1638_FONT_INITIALIZER;
+
+/**
+ * @brief The lookup char_to_segment_code() does now.
+ */
+static uint8_t bench_table_glyph(char c) {
+    uint8_t index = (uint8_t)c;
+    return (index < sizeof(bench_font)) ? bench_font[index] : 0x00;
+}
+
+/**
+ * @brief Draws printable text through one glyph lookup, as tm1638_display_char() does.
+ * @param tm Pointer to the TM1638 handle.
+ * @param glyph The lookup.
+ * @param text Characters to draw.
+ * @param len Length of text.
+ * @return CPU time per character, in tenths of BENCH_CPU_UNIT.
+ */
+static uint32_t bench_glyph_pass(TM1638 *tm, uint8_t (*glyph)(char), const char *text, uint32_t len) {
+    uint32_t start = bench_cpu_now();
+
+    for (uint32_t run = 0; run < BENCH_GLYPH_RUNS; run++) {
+        for (uint32_t i = 0; i < len; i++) {
+            tm1638_set_segment(tm, (uint8_t)(i & 7) + 1, glyph(text[i]));
+        }
+    }
+    return (uint32_t)((uint64_t)(bench_cpu_now() - start) * 10U / ((uint64_t)BENCH_GLYPH_RUNS * len));
+}
+
+/**
+ * @brief Compares the font table with the old switch; only the framebuffer is touched.
+ * @param tm Pointer to the TM1638 handle.
+ */
+static void bench_glyphs(TM1638 *tm) {
+    static const struct {
+        const char *name;
+        uint8_t (*glyph)(char);
+    } lookups[] = {
+        {"Font table (now)", bench_table_glyph},
+        {"Switch (before)", bench_switch_glyph},
+    };
+    char text[256];
+    uint32_t lcg = 1;
+
+    // Printable characters in random order, so the switch's branches are not trained by a pattern
+    for (uint32_t i = 0; i < sizeof(text); i++) {
+        lcg = lcg * 1664525U + 1013904223U;
+        text[i] = (char)(' ' + (lcg >> 24) % ('~' - ' ' + 1));
+    }
+
+    printf("\n| Glyph lookup | Printable chars with a glyph | %s per char |\n", BENCH_CPU_UNIT);
+    printf("|--------------|-----------------------------:|------:|\n");
+    for (size_t n = 0; n < sizeof(lookups) / sizeof(lookups[0]); n++) {
+        uint32_t lit = 0;
+        uint32_t tenths;
+
+        for (char c = ' '; c <= '~'; c++) {
+            lit += (uint32_t)(lookups[n].glyph(c) != 0);
+        }
+        (void)bench_glyph_pass(tm, lookups[n].glyph, text, sizeof(text)); // Warm up
+        tenths = bench_glyph_pass(tm, lookups[n].glyph, text, sizeof(text));
+        printf("| %s | %u | %u.%u |\n", lookups[n].name, (unsigned)lit, (unsigned)(tenths / 10U),
+               (unsigned)(tenths % 10U));
+    }
+
+    tm1638_display_clear(tm);
+    tm1638_flush(tm);
+}
+
+// --- Runner ---
+
+/**
+ * @brief Prints the header of a result table.
+ */
+static void bench_header(void) {
+#ifdef TM1638_HOST_MOCK
+    printf("| Call | Bits | Frames | GPIO writes | Accesses | Cycles | µs |\n");
+    printf("|------|-----:|-------:|------------:|---------:|-------:|---:|\n");
+#else
+    printf("| Call | Cycles | µs |\n");
+    printf("|------|-------:|---:|\n");
+#endif
+}
+
+/**
+ * @brief Runs one case BENCH_RUNS times and prints its table row.
+ * @param tm Pointer to the TM1638 handle.
+ * @param label Row label, or NULL for the case name.
+ * @param c The case.
+ * @return Average cycles per call.
+ */
+static uint32_t bench_row(TM1638 *tm, const char *label, const BenchCase *c) {
+    uint32_t cycles_per_us = SystemCoreClock / 1000000U;
+    uint64_t cycles = 0;
+#ifdef TM1638_HOST_MOCK
+    uint64_t bits = 0, frames = 0, writes = 0, accesses = 0;
+#endif
+
+    for (uint32_t run = 0; run < BENCH_RUNS; run++) {
+        uint32_t start;
+
+        if (c->prepare != NULL) {
+            c->prepare(tm);
+        }
+#ifdef TM1638_HOST_MOCK
+        tm1638_sim_reset_counters(bench_sim);
+        uint32_t accesses_before = tm1638_mock_accesses();
+#endif
+        start = TM1638_CYCLES();
+        c->call(tm);
+        cycles += (uint32_t)(TM1638_CYCLES() - start);
+#ifdef TM1638_HOST_MOCK
+        accesses += tm1638_mock_accesses() - accesses_before;
+        bits += bench_sim->bits;
+        frames += bench_sim->frames;
+        writes += bench_sim->gpio_calls;
+#endif
+    }
+    cycles /= BENCH_RUNS;
+    if (label == NULL) {
+        label = c->name;
+    }
+#ifdef TM1638_HOST_MOCK
+    printf("| `%s` | %u | %u | %u | %u | %u | %.1f |\n", label, (unsigned)(bits / BENCH_RUNS),
+           (unsigned)(frames / BENCH_RUNS), (unsigned)(writes / BENCH_RUNS),
+           (unsigned)(accesses / BENCH_RUNS), (unsigned)cycles, (double)cycles / cycles_per_us);
+#else
+    printf("| `%s` | %u | %u.%u |\n", label, (unsigned)cycles, (unsigned)(cycles / cycles_per_us),
+           (unsigned)(cycles * 10U / cycles_per_us % 10U));
+#endif
+    return (uint32_t)cycles;
+}
+
+/**
+ * @brief Runs every case on an initialized handle and prints one table row per case.
+ * @param tm Pointer to the TM1638 handle.
+ */
+void tm1638_bench(TM1638 *tm) {
+    tm1638_keypad_init(&bench_keypad, tm, &tm1638_board_led_key);
+    bench_header();
+    for (size_t i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++) {
+        (void)bench_row(tm, NULL, &bench_cases[i]);
+    }
+    bench_glyphs(tm);
+}
+
+#ifdef TM1638_HOST_MOCK
+// --- Host ---
+
+// Static so the timer + DMA transport gets 32-bit addresses
+static TM1638 display;
+static TM1638_Sim sim;
+static SPI_HandleTypeDef hspi;
+static TIM_TypeDef tim;
+static TIM_HandleTypeDef htim = {&tim};
+static DMA_HandleTypeDef hdma;
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *spi) {
+    if (spi == display.hspi) {
+        tm1638_spi_tx_complete(&display);
+    }
+}
+
+/**
+ * @brief Pins high, then outputs (or alternate function) without pull.
+ */
+static void gpio_init(uint16_t pins, uint32_t mode) {
+    GPIO_InitTypeDef init = {pins, mode, GPIO_NOPULL, GPIO_SPEED_FREQ_VERY_HIGH, 5};
+    HAL_GPIO_WritePin(GPIOA, pins, GPIO_PIN_SET);
+    HAL_GPIO_Init(GPIOA, &init);
+}
+
+/**
+ * @brief Sets up the bench handle and its model; CLK/DIO/STB are PA0/PA1/PA2, or PA5/PA7/PA4 for SPI.
+ * @param transport The bus implementation to use.
+ * @param open_drain DIO as open-drain output instead of push-pull (not for SPI).
+ */
+static void bench_setup(const TM1638_Transport *transport, bool open_drain) {
+    bool spi = (transport == &tm1638_transport_spi);
+
+    tm1638_mock_init();
+    memset(&display, 0, sizeof(display));
+    tm1638_sim_init(&sim);
+    if (spi) {
+        gpio_init(GPIO_PIN_4, GPIO_MODE_OUTPUT_PP);
+        gpio_init(GPIO_PIN_5 | GPIO_PIN_7, GPIO_MODE_AF_PP);
+        tm1638_mock_spi_pins(&hspi, GPIOA, GPIO_PIN_5, GPIO_PIN_7);
+        tm1638_mock_connect(&sim, GPIOA, GPIO_PIN_5, GPIOA, GPIO_PIN_7, GPIOA, GPIO_PIN_4);
+        display.hspi = &hspi;
+        display.dio_pin = GPIO_PIN_7;
+        display.stb_pin = GPIO_PIN_4;
+    } else {
+        gpio_init(GPIO_PIN_0 | GPIO_PIN_2, GPIO_MODE_OUTPUT_PP);
+        gpio_init(GPIO_PIN_1, open_drain ? GPIO_MODE_OUTPUT_OD : GPIO_MODE_OUTPUT_PP);
+        tm1638_mock_connect(&sim, GPIOA, GPIO_PIN_0, GPIOA, GPIO_PIN_1, GPIOA, GPIO_PIN_2);
+        display.clk_port = GPIOA;
+        display.clk_pin = GPIO_PIN_0;
+        display.dio_pin = GPIO_PIN_1;
+        display.stb_pin = GPIO_PIN_2;
+        display.htim = &htim;
+        display.hdma = &hdma;
+    }
+    display.dio_port = GPIOA;
+    display.stb_port = GPIOA;
+    bench_sim = &sim;
+
+    tm1638_init_transport(&display, transport, 7);
+}
+
+/**
+ * @brief Runs the per-call suite on one transport.
+ */
+static void bench_transport(const char *name, const TM1638_Transport *transport) {
+    bench_setup(transport, false);
+    printf("\n### %s\n\n", name);
+    tm1638_bench(&display);
+}
+
+/**
+ * @brief Push-pull DIO, turned around with two MODER rewrites per key read,
+ *        against open-drain DIO, which is never reconfigured.
+ */
+static void bench_dio_mode(void) {
+    static const BenchCase scan = {"tm1638_scan_buttons", NULL, call_scan_buttons};
+    static const BenchCase flush = {"tm1638_display_txt (8 new digits) + flush", prep_blank, call_display_txt};
+    uint32_t cycles[2];
+
+    printf("\n### DIO push-pull vs open-drain (tm1638_transport_reg)\n\n");
+    bench_header();
+    for (int od = 0; od < 2; od++) {
+        char label[64];
+
+        bench_setup(&tm1638_transport_reg, od != 0);
+        snprintf(label, sizeof(label), "%s, %s", scan.name, od ? "open-drain" : "push-pull");
+        cycles[od] = bench_row(&display, label, &scan);
+        snprintf(label, sizeof(label), "%s, %s", flush.name, od ? "open-drain" : "push-pull");
+        (void)bench_row(&display, label, &flush);
+    }
+    printf("\nBack-to-back scan rate: %u/s push-pull, %u/s open-drain\n",
+           (unsigned)(SystemCoreClock / cycles[0]), (unsigned)(SystemCoreClock / cycles[1]));
+}
+
+int main(void) {
+    printf("%u runs per call, %u MHz core\n", (unsigned)BENCH_RUNS, (unsigned)(SystemCoreClock / 1000000U));
+    bench_transport("tm1638_transport_hal", &tm1638_transport_hal);
+    bench_transport("tm1638_transport_reg", &tm1638_transport_reg);
+    bench_transport("tm1638_transport_spi", &tm1638_transport_spi);
+    bench_transport("tm1638_transport_tim_dma", &tm1638_transport_tim_dma);
+    bench_dio_mode();
+    return 0;
+}
+#endif
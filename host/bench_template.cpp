@@ -0,0 +1,252 @@
+/**
+ * @file bench_template.cpp
+ * @brief tm1638::Display (pins fixed at compile time) against the register transport.
+ *
+ * Both drive a module on the same three pins, CLK/DIO/STB = pins 0/1/2 of
+ * BENCH_PORT (GPIOA_BASE by default).
+ *
+ * Host: built against the mock HAL (make -C host bench), the same call
+ * sequence is recorded as a VCD through each variant and the two files must
+ * match, edge for edge and in time. The table then shows GPIO writes,
+ * register accesses and virtual cycles per call, which model the bus only:
+ * the template's gain is in the instructions around each store, which the
+ * mock does not see. Core cycles and flash size need an ARM build.
+ *
+ * Target: add this file to the firmware and call tm1638_bench_template()
+ * with printf() retargeted and the pins configured as outputs. It reports
+ * DWT->CYCCNT cycles per call for both variants.
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TM1638.hpp"
+#ifdef TM1638_HOST_MOCK
+#include "TM1638_sim.h"
+#include "tm1638_mock.h"
+#endif
+
+/** @brief Measured runs per call. */
+#ifndef BENCH_RUNS
+#define BENCH_RUNS 100
+#endif
+
+/** @brief Port base address of the three pins. */
+#ifndef BENCH_PORT
+#define BENCH_PORT GPIOA_BASE
+#endif
+
+#ifndef TM1638_CYCLES
+#ifdef TM1638_HOST_MOCK
+#define TM1638_CYCLES() tm1638_mock_cycles()
+#else
+#define TM1638_CYCLES() (DWT->CYCCNT)
+#endif
+#endif
+
+void tm1638_bench_template();
+
+using Panel = tm1638::Display<BENCH_PORT, 0, BENCH_PORT, 1, BENCH_PORT, 2>;
+
+static Panel panel;
+static TM1638 plain;
+
+#ifdef TM1638_HOST_MOCK
+static TM1638_Sim sim;
+#endif
+
+/** @brief One call under test, on either handle. */
+struct BenchCase {
+    const char *name;
+    void (*prepare)(TM1638 *tm); // Not measured, may be nullptr
+    void (*call)(TM1638 *tm);
+};
+
+static void prep_blank(TM1638 *tm) {
+    tm1638_display_txt(tm, "        ");
+    tm1638_flush(tm);
+}
+
+static void prep_led_off(TM1638 *tm) {
+    tm1638_set_led(tm, 1, false);
+    tm1638_flush(tm);
+}
+
+static void call_display_txt(TM1638 *tm) {
+    tm1638_display_txt(tm, "12345678");
+    tm1638_flush(tm);
+}
+
+static void call_set_led(TM1638 *tm) {
+    tm1638_set_led(tm, 1, true);
+    tm1638_flush(tm);
+}
+
+static void call_scan_buttons(TM1638 *tm) {
+    (void)tm1638_scan_buttons(tm);
+}
+
+static const BenchCase bench_cases[] = {
+    {"tm1638_display_txt (8 new digits) + flush", prep_blank, call_display_txt},
+    {"tm1638_set_led + flush", prep_led_off, call_set_led},
+    {"tm1638_scan_buttons", nullptr, call_scan_buttons},
+};
+
+/**
+ * @brief Initializes the register-transport handle on the panel's pins.
+ */
+static void plain_init() {
+    GPIO_TypeDef *port = reinterpret_cast<GPIO_TypeDef *>(BENCH_PORT);
+
+    memset(&plain, 0, sizeof(plain));
+    plain.clk_port = port;
+    plain.clk_pin = 1U << 0;
+    plain.dio_port = port;
+    plain.dio_pin = 1U << 1;
+    plain.stb_port = port;
+    plain.stb_pin = 1U << 2;
+    tm1638_init_transport(&plain, &tm1638_transport_reg, 7);
+}
+
+/**
+ * @brief Runs one case on one handle and prints its table row.
+ */
+static void bench_row(TM1638 *tm, const char *variant, const BenchCase *c) {
+    uint64_t cycles = 0;
+#ifdef TM1638_HOST_MOCK
+    uint64_t writes = 0, accesses = 0;
+#endif
+
+    for (uint32_t run = 0; run < BENCH_RUNS; run++) {
+        if (c->prepare != nullptr) {
+            c->prepare(tm);
+        }
+#ifdef TM1638_HOST_MOCK
+        tm1638_sim_reset_counters(&sim);
+        uint32_t accesses_before = tm1638_mock_accesses();
+#endif
+        uint32_t start = TM1638_CYCLES();
+        c->call(tm);
+        cycles += static_cast<uint32_t>(TM1638_CYCLES() - start);
+#ifdef TM1638_HOST_MOCK
+        accesses += tm1638_mock_accesses() - accesses_before;
+        writes += sim.gpio_calls;
+#endif
+    }
+#ifdef TM1638_HOST_MOCK
+    printf("| `%s` | %s | %u | %u | %u |\n", c->name, variant, static_cast<unsigned>(writes / BENCH_RUNS),
+           static_cast<unsigned>(accesses / BENCH_RUNS), static_cast<unsigned>(cycles / BENCH_RUNS));
+#else
+    printf("| `%s` | %s | %u |\n", c->name, variant, static_cast<unsigned>(cycles / BENCH_RUNS));
+#endif
+}
+
+/**
+ * @brief Benchmarks both variants; the pins must be outputs (and on host, connected to the model).
+ */
+void tm1638_bench_template() {
+    printf("\n### tm1638::Display vs tm1638_transport_reg\n\n");
+    // Display embeds a full TM1638, so the two match: the template saves no RAM
+    printf("Handle size: %u bytes (TM1638), %u bytes (Display)\n\n", static_cast<unsigned>(sizeof(TM1638)),
+           static_cast<unsigned>(sizeof(Panel)));
+#ifdef TM1638_HOST_MOCK
+    printf("| Call | Variant | GPIO writes | Accesses | Cycles |\n");
+    printf("|------|---------|------------:|---------:|-------:|\n");
+#else
+    printf("| Call | Variant | Cycles |\n");
+    printf("|------|---------|-------:|\n");
+#endif
+    plain_init();
+    panel.init(7);
+    for (const BenchCase &c : bench_cases) {
+        bench_row(&plain, "register transport", &c);
+        bench_row(panel.handle(), "template", &c);
+    }
+}
+
+#ifdef TM1638_HOST_MOCK
+/**
+ * @brief Resets the mock with PA0-PA2 as outputs and the model connected.
+ * @param open_drain DIO as open-drain output instead of push-pull.
+ */
+static void bench_setup(bool open_drain) {
+    GPIO_TypeDef *port = reinterpret_cast<GPIO_TypeDef *>(BENCH_PORT);
+    GPIO_InitTypeDef init = {GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2, GPIO_MODE_OUTPUT_PP,
+                             GPIO_NOPULL, GPIO_SPEED_FREQ_VERY_HIGH, 0};
+
+    tm1638_mock_init();
+    HAL_GPIO_WritePin(port, init.Pin, GPIO_PIN_SET);
+    HAL_GPIO_Init(port, &init);
+    if (open_drain) {
+        init.Pin = GPIO_PIN_1;
+        init.Mode = GPIO_MODE_OUTPUT_OD;
+        HAL_GPIO_Init(port, &init);
+    }
+    tm1638_sim_init(&sim);
+    tm1638_mock_connect(&sim, port, GPIO_PIN_0, port, GPIO_PIN_1, port, GPIO_PIN_2);
+}
+
+/**
+ * @brief Records init, a text flush, an LED flush and a key scan as VCD text.
+ * @param use_template Drive the bus through the template instead of the register transport.
+ * @param open_drain DIO as open-drain output instead of push-pull.
+ * @param clk_ns CLK low/high time set with tm1638_set_timing() (0: full speed).
+ * @return The VCD file contents, to be freed by the caller, or nullptr if the
+ *         model saw a bad frame or a key read sooner than Twait.
+ */
+static char *bench_trace(bool use_template, bool open_drain, uint32_t clk_ns) {
+    char *text = nullptr;
+    size_t size = 0;
+    FILE *out = open_memstream(&text, &size);
+    TM1638 *tm;
+
+    bench_setup(open_drain);
+    tm1638_sim_set_keys(&sim, 0x22222222UL);
+    tm1638_sim_vcd_open(&sim, out, 0);
+    if (use_template) {
+        panel.init(7);
+        tm = panel.handle();
+    } else {
+        plain_init();
+        tm = &plain;
+    }
+    tm1638_set_timing(tm, clk_ns, clk_ns);
+    tm1638_display_txt(tm, "12.34");
+    tm1638_flush(tm);
+    tm1638_set_led(tm, 3, true);
+    tm1638_flush(tm);
+    (void)tm1638_scan_buttons(tm);
+    tm1638_sim_vcd_close(&sim);
+    fclose(out);
+    if (sim.errors != 0 || sim.twait_errors != 0) {
+        free(text);
+        return nullptr;
+    }
+    return text;
+}
+
+int main() {
+    bool same = true;
+
+    for (int mode = 0; mode < 3; mode++) {
+        bool open_drain = mode == 1;
+        uint32_t clk_ns = (mode == 2) ? 500 : 0;
+        char *plain_trace = bench_trace(false, open_drain, clk_ns);
+        char *panel_trace = bench_trace(true, open_drain, clk_ns);
+        bool match = plain_trace != nullptr && panel_trace != nullptr && strcmp(plain_trace, panel_trace) == 0;
+
+        printf("Bus traffic of both variants, %s DIO, %u ns CLK phases: %s (%u bytes of VCD)\n",
+               open_drain ? "open-drain" : "push-pull", static_cast<unsigned>(clk_ns), match ? "identical" : "DIFFERENT",
+               static_cast<unsigned>(plain_trace != nullptr ? strlen(plain_trace) : 0));
+        free(plain_trace);
+        free(panel_trace);
+        same = same && match;
+    }
+
+    bench_setup(false);
+    tm1638_bench_template();
+    return same ? 0 : 1;
+}
+#endif
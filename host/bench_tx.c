@@ -0,0 +1,63 @@
+/**
+ * @file bench_tx.c
+ * @brief CPU time of the register transport's byte loop, with and without TM1638_USE_TX_TABLE.
+ *
+ * The bus traffic of both loops is identical (test_transports checks it on
+ * the model), so only the instructions between the BSRR stores differ, and
+ * the mock's register proxies would hide them. This program therefore links
+ * TM1638.c compiled as plain C: the ports are ordinary memory at their real
+ * addresses, stores cost what a store costs, and nothing decodes them.
+ *
+ * make -C host bench builds it once per variant and prints the object sizes
+ * for the flash cost of the table. On target, build bench.c with and without
+ * the option and compare its flush rows instead.
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <time.h>
+#include "TM1638.h"
+
+/** @brief Timed flushes. */
+#define BENCH_TX_RUNS 200000U
+
+static TM1638 display;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int main(void) {
+    GPIO_InitTypeDef init = {GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2, GPIO_MODE_OUTPUT_PP,
+                             GPIO_NOPULL, GPIO_SPEED_FREQ_VERY_HIGH, 0};
+    uint64_t start, elapsed;
+
+    HAL_GPIO_Init(GPIOA, &init);
+    display.clk_port = GPIOA;
+    display.clk_pin = GPIO_PIN_0;
+    display.dio_port = GPIOA;
+    display.dio_pin = GPIO_PIN_1;
+    display.stb_port = GPIOA;
+    display.stb_pin = GPIO_PIN_2;
+    tm1638_init_transport(&display, &tm1638_transport_reg, 7);
+
+    start = now_ns();
+    for (uint32_t run = 0; run < BENCH_TX_RUNS; run++) {
+        // Alternate the text so every flush sends all 8 digits (136 bits)
+        tm1638_display_txt(&display, (run & 1U) ? "12345678" : "87654321");
+        tm1638_flush(&display);
+    }
+    elapsed = now_ns() - start;
+
+#ifdef TM1638_USE_TX_TABLE
+    printf("| TX table | ");
+#else
+    printf("| Bit test | ");
+#endif
+    printf("%.1f | %.2f |\n", (double)elapsed / BENCH_TX_RUNS, (double)elapsed / BENCH_TX_RUNS / 136.0);
+    return 0;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file check.h
+ * @brief Minimal assertions for the host tests.
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+
+#ifndef TM1638_CHECK_H_
+#define TM1638_CHECK_H_
+
+#include <stdio.h>
+
+/** @brief Failed checks so far; main() returns it as the exit status. */
+static int check_failures;
+
+/** @brief Reports a failed condition with its location and keeps going. */
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            check_failures++;                                                    \
+        }                                                                        \
+    } while (0)
+
+/** @brief Like CHECK(), for two unsigned values that must be equal. */
+#define CHECK_EQ(a, b)                                                           \
+    do {                                                                         \
+        unsigned long check_a_ = (unsigned long)(a);                             \
+        unsigned long check_b_ = (unsigned long)(b);                             \
+        if (check_a_ != check_b_) {                                              \
+            fprintf(stderr, "%s:%d: check failed: %s == %s (0x%lX != 0x%lX)\n",  \
+                    __FILE__, __LINE__, #a, #b, check_a_, check_b_);             \
+            check_failures++;                                                    \
+        }                                                                        \
+    } while (0)
+
+/** @brief Prints the result line and yields the exit status. */
+#define CHECK_DONE(name)                                                         \
+    (printf("%s: %s\n", (name), check_failures ? "FAILED" : "passed"), check_failures != 0)
+
+#endif /* TM1638_CHECK_H_ */
@@ -0,0 +1,259 @@
+/**
+ * @file stm32f4xx_hal.h
+ * @brief Host stand-in for the STM32F4 HAL, wiring the driver's GPIO accesses to TM1638_Sim.
+ *
+ * Declares the subset of the HAL and CMSIS the driver uses, with the GPIO
+ * ports at their real addresses (GPIOA_BASE, ...). When TM1638.c is compiled
+ * as C++ the port registers are small proxy objects: every BSRR, ODR, MODER,
+ * OTYPER or PUPDR store and every IDR load goes through tm1638_mock_store() /
+ * tm1638_mock_load(), which track the pin levels and feed connected chip
+ * models with tm1638_sim_pins(). The HAL, register (with or without the TX
+ * table), open-drain, parallel, SPI and timer + DMA transports therefore run
+ * unchanged on the host. C files see the same layout as plain registers, e.g.
+ * for tests that only use the driver API.
+ *
+ * The SPI, timer and DMA functions are modelled by the mock too: see
+ * tm1638_mock.h for connecting chips and for the virtual clock.
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+
+#ifndef STM32F4XX_HAL_H
+#define STM32F4XX_HAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Set by this header, so sources can tell a host build from a target build. */
+#define TM1638_HOST_MOCK
+
+#define HAL_GPIO_MODULE_ENABLED
+#define HAL_SPI_MODULE_ENABLED
+#define HAL_TIM_MODULE_ENABLED
+#define HAL_DMA_MODULE_ENABLED
+
+#define __IO volatile
+
+/**
+ * @brief Stores a value to a mock peripheral register and applies its side effects.
+ * @param reg Register address.
+ * @param value Value written.
+ */
+void tm1638_mock_store(volatile uint32_t *reg, uint32_t value);
+
+/**
+ * @brief Loads a mock peripheral register (IDR reads the current pin levels).
+ * @param reg Register address.
+ * @return The register value.
+ */
+uint32_t tm1638_mock_load(const volatile uint32_t *reg);
+
+/**
+ * @brief Reads the virtual cycle counter, which stops in __WFI(); every read advances it by one cycle.
+ * @return The low 32 bits of the counter.
+ */
+uint32_t tm1638_mock_cycles(void);
+
+#ifdef __cplusplus
+}
+
+/** @brief Memory-mapped register whose accesses are routed through the mock. */
+struct Tm1638MockReg {
+    volatile uint32_t value;
+
+    operator uint32_t() const { return tm1638_mock_load(&value); }
+    Tm1638MockReg &operator=(uint32_t v) { tm1638_mock_store(&value, v); return *this; }
+    Tm1638MockReg &operator|=(uint32_t v) { tm1638_mock_store(&value, tm1638_mock_load(&value) | v); return *this; }
+    Tm1638MockReg &operator&=(uint32_t v) { tm1638_mock_store(&value, tm1638_mock_load(&value) & v); return *this; }
+};
+
+/** @brief The DWT cycle counter, counting virtual cycles. */
+struct Tm1638MockCycles {
+    operator uint32_t() const { return tm1638_mock_cycles(); }
+};
+
+typedef Tm1638MockReg Tm1638GpioReg;
+typedef Tm1638MockCycles Tm1638CycleReg;
+
+extern "C" {
+#else
+typedef volatile uint32_t Tm1638GpioReg;
+typedef volatile uint32_t Tm1638CycleReg;
+#endif
+
+// --- GPIO ---
+
+typedef struct {
+    Tm1638GpioReg MODER;
+    Tm1638GpioReg OTYPER;
+    Tm1638GpioReg OSPEEDR;
+    Tm1638GpioReg PUPDR;
+    Tm1638GpioReg IDR;
+    Tm1638GpioReg ODR;
+    Tm1638GpioReg BSRR;
+    Tm1638GpioReg LCKR;
+    Tm1638GpioReg AFR[2];
+} GPIO_TypeDef;
+
+#define AHB1PERIPH_BASE 0x40020000UL
+#define GPIOA_BASE (AHB1PERIPH_BASE + 0x0000UL)
+#define GPIOB_BASE (AHB1PERIPH_BASE + 0x0400UL)
+#define GPIOC_BASE (AHB1PERIPH_BASE + 0x0800UL)
+#define GPIOD_BASE (AHB1PERIPH_BASE + 0x0C00UL)
+#define GPIOE_BASE (AHB1PERIPH_BASE + 0x1000UL)
+
+#define GPIOA ((GPIO_TypeDef *)GPIOA_BASE)
+#define GPIOB ((GPIO_TypeDef *)GPIOB_BASE)
+#define GPIOC ((GPIO_TypeDef *)GPIOC_BASE)
+#define GPIOD ((GPIO_TypeDef *)GPIOD_BASE)
+#define GPIOE ((GPIO_TypeDef *)GPIOE_BASE)
+
+#define GPIO_PIN_0 ((uint16_t)0x0001)
+#define GPIO_PIN_1 ((uint16_t)0x0002)
+#define GPIO_PIN_2 ((uint16_t)0x0004)
+#define GPIO_PIN_3 ((uint16_t)0x0008)
+#define GPIO_PIN_4 ((uint16_t)0x0010)
+#define GPIO_PIN_5 ((uint16_t)0x0020)
+#define GPIO_PIN_6 ((uint16_t)0x0040)
+#define GPIO_PIN_7 ((uint16_t)0x0080)
+#define GPIO_PIN_8 ((uint16_t)0x0100)
+#define GPIO_PIN_9 ((uint16_t)0x0200)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#define GPIO_PIN_11 ((uint16_t)0x0800)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+#define GPIO_PIN_14 ((uint16_t)0x4000)
+#define GPIO_PIN_15 ((uint16_t)0x8000)
+
+typedef enum {
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_MODE_INPUT 0x00000000U
+#define GPIO_MODE_OUTPUT_PP 0x00000001U
+#define GPIO_MODE_OUTPUT_OD 0x00000011U
+#define GPIO_MODE_AF_PP 0x00000002U
+#define GPIO_MODE_AF_OD 0x00000012U
+
+#define GPIO_NOPULL 0x00000000U
+#define GPIO_PULLUP 0x00000001U
+#define GPIO_PULLDOWN 0x00000002U
+
+#define GPIO_SPEED_FREQ_LOW 0x00000000U
+#define GPIO_SPEED_FREQ_VERY_HIGH 0x00000003U
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+
+// --- System ---
+
+typedef enum {
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+extern uint32_t SystemCoreClock;
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+/** @brief Sleeps until the next interrupt: the virtual clock jumps to the next SysTick. */
+void __WFI(void);
+
+// --- Core debug ---
+
+typedef struct {
+    uint32_t CTRL;
+    Tm1638CycleReg CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern DWT_Type tm1638_mock_dwt;
+extern CoreDebug_Type tm1638_mock_core_debug;
+
+#define DWT (&tm1638_mock_dwt)
+#define CoreDebug (&tm1638_mock_core_debug)
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+// --- DMA ---
+
+typedef struct __DMA_HandleTypeDef {
+    void *Instance;
+    void *Parent;
+    void (*XferCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+    void (*XferErrorCallback)(struct __DMA_HandleTypeDef *hdma);
+    void (*XferAbortCallback)(struct __DMA_HandleTypeDef *hdma);
+} DMA_HandleTypeDef;
+
+/**
+ * @brief Arms a memory-to-peripheral transfer; it moves one word per update
+ *        event of the timer started next with HAL_TIM_Base_Start().
+ */
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress,
+                                   uint32_t DstAddress, uint32_t DataLength);
+
+// --- Timer ---
+
+typedef struct {
+    uint32_t DIER;
+    uint32_t PSC;
+    uint32_t ARR;
+} TIM_TypeDef;
+
+typedef struct {
+    TIM_TypeDef *Instance;
+} TIM_HandleTypeDef;
+
+#define TIM_DMA_UPDATE (1UL << 8)
+#define __HAL_TIM_ENABLE_DMA(__HANDLE__, __DMA__) ((__HANDLE__)->Instance->DIER |= (__DMA__))
+#define __HAL_TIM_DISABLE_DMA(__HANDLE__, __DMA__) ((__HANDLE__)->Instance->DIER &= ~(__DMA__))
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef *htim);
+
+// --- SPI ---
+
+typedef struct {
+    uint32_t CR1;
+} SPI_TypeDef;
+
+typedef struct __SPI_HandleTypeDef {
+    SPI_TypeDef *Instance;
+} SPI_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi);
+
+/** @brief Called when a HAL_SPI_Transmit_DMA() transfer is done (weak, override it). */
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32F4XX_HAL_H */
@@ -0,0 +1,350 @@
+/**
+ * @file test_keypad.c
+ * @brief Runs the key event engine against the chip model, one poll per virtual millisecond.
+ *
+ * Keys are pressed and released on the model of an LED&KEY board and read
+ * back by tm1638_poll() over the register transport, so every event below
+ * went through a real key scan. Each case checks the events, their order
+ * and their time stamps. tm1638_wait_event() runs on the mock's clock
+ * instead: its __WFI() sleeps to the next tick with DWT->CYCCNT stopped.
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+#include <string.h>
+#include "TM1638.h"
+#include "TM1638_sim.h"
+#include "tm1638_mock.h"
+#include "check.h"
+
+static TM1638 display;
+static TM1638_Sim sim;
+static TM1638_Keypad keypad;
+
+/** @brief Time passed to the last tm1638_poll(). */
+static uint32_t now_ms;
+
+/**
+ * @brief One LED&KEY module on PA0-PA2 with the model connected, and a fresh keypad.
+ */
+static void setup(void) {
+    GPIO_InitTypeDef init = {GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2, GPIO_MODE_OUTPUT_PP,
+                             GPIO_NOPULL, GPIO_SPEED_FREQ_VERY_HIGH, 0};
+
+    tm1638_mock_init();
+    HAL_GPIO_WritePin(GPIOA, init.Pin, GPIO_PIN_SET);
+    HAL_GPIO_Init(GPIOA, &init);
+    tm1638_sim_init(&sim);
+    tm1638_mock_connect(&sim, GPIOA, GPIO_PIN_0, GPIOA, GPIO_PIN_1, GPIOA, GPIO_PIN_2);
+    memset(&display, 0, sizeof(display));
+    display.clk_port = GPIOA;
+    display.clk_pin = GPIO_PIN_0;
+    display.dio_port = GPIOA;
+    display.dio_pin = GPIO_PIN_1;
+    display.stb_port = GPIOA;
+    display.stb_pin = GPIO_PIN_2;
+    tm1638_init_transport(&display, &tm1638_transport_reg, 7);
+
+    tm1638_keypad_init(&keypad, &display, &tm1638_board_led_key);
+    now_ms = 0;
+}
+
+/**
+ * @brief Holds a key state on the model for some milliseconds, polling every millisecond.
+ * @param keys Bit i set when S(i+1) is down.
+ * @param ms Number of polls.
+ */
+static void run(uint32_t keys, uint32_t ms) {
+    uint32_t matrix = 0;
+
+    for (uint8_t i = 0; i < tm1638_board_led_key.key_count; i++) {
+        if (keys & (1UL << i)) {
+            matrix |= 1UL << tm1638_board_led_key.key_bit[i];
+        }
+    }
+    tm1638_sim_set_keys(&sim, matrix);
+    for (uint32_t n = 0; n < ms; n++) {
+        tm1638_poll(&keypad, ++now_ms);
+    }
+}
+
+/**
+ * @brief Takes the next event and checks it.
+ */
+static void expect(uint8_t key, TM1638_KeyEventType type, uint32_t time_ms) {
+    TM1638_KeyEvent event;
+
+    CHECK(tm1638_get_event(&keypad, &event));
+    CHECK_EQ(event.key, key);
+    CHECK_EQ(event.type, type);
+    CHECK_EQ(event.time_ms, time_ms);
+}
+
+/**
+ * @brief Checks that no event is waiting.
+ */
+static void expect_none(void) {
+    TM1638_KeyEvent event;
+
+    CHECK(!tm1638_get_event(&keypad, &event));
+}
+
+static void test_bounce(void) {
+    uint32_t edge_ms;
+
+    setup();
+    keypad.hold_ms = 0;
+    run(0, 10);
+
+    // Contacts bouncing faster than the debounce time give no event at all
+    for (uint8_t n = 0; n < 4; n++) {
+        run(0x01, 3);
+        run(0x00, 3);
+    }
+    expect_none();
+
+    // Once S1 settles, the press is accepted by the poll a debounce time
+    // after the last edge, and stamped with that edge
+    edge_ms = now_ms + 1;
+    run(0x01, TM1638_DEBOUNCE_MS);
+    expect_none();
+    run(0x01, 1);
+    expect(1, TM1638_KEY_PRESS, edge_ms);
+
+    // A short dropout while held is a glitch, not a release
+    run(0x00, TM1638_DEBOUNCE_MS / 2);
+    run(0x01, 2 * TM1638_DEBOUNCE_MS);
+    expect_none();
+
+    // Bouncing release: one event, at the last edge
+    for (uint8_t n = 0; n < 3; n++) {
+        run(0x00, 2);
+        run(0x01, 2);
+    }
+    edge_ms = now_ms + 1;
+    run(0x00, TM1638_DEBOUNCE_MS + 1);
+    expect(1, TM1638_KEY_RELEASE, edge_ms);
+    expect_none();
+
+    // Debounce times are per key
+    tm1638_keypad_set_debounce(&keypad, 2, 50);
+    edge_ms = now_ms + 1;
+    run(0x03, TM1638_DEBOUNCE_MS + 1);
+    expect(1, TM1638_KEY_PRESS, edge_ms);
+    run(0x03, 50 - TM1638_DEBOUNCE_MS - 1);
+    expect_none();
+    run(0x03, 1);
+    expect(2, TM1638_KEY_PRESS, edge_ms);
+    expect_none();
+
+    CHECK_EQ(keypad.dropped, 0);
+    CHECK_EQ(sim.errors, 0);
+    CHECK_EQ(sim.twait_errors, 0);
+}
+
+static void test_hold(void) {
+    uint32_t edge_ms;
+
+    setup();
+    run(0, 10);
+
+    // One hold event, TM1638_HOLD_MS after the press edge
+    edge_ms = now_ms + 1;
+    run(0x02, TM1638_DEBOUNCE_MS + 1);
+    expect(2, TM1638_KEY_PRESS, edge_ms);
+    run(0x02, TM1638_HOLD_MS - TM1638_DEBOUNCE_MS - 1);
+    expect_none();
+    run(0x02, 1);
+    expect(2, TM1638_KEY_HOLD, edge_ms + TM1638_HOLD_MS);
+    run(0x02, 2 * TM1638_HOLD_MS);
+    expect_none();
+
+    edge_ms = now_ms + 1;
+    run(0x00, TM1638_DEBOUNCE_MS + 1);
+    expect(2, TM1638_KEY_RELEASE, edge_ms);
+
+    // A shorter press gives none
+    edge_ms = now_ms + 1;
+    run(0x02, TM1638_HOLD_MS / 2);
+    run(0x00, TM1638_DEBOUNCE_MS + 1);
+    expect(2, TM1638_KEY_PRESS, edge_ms);
+    expect(2, TM1638_KEY_RELEASE, edge_ms + TM1638_HOLD_MS / 2);
+    expect_none();
+    CHECK_EQ(keypad.dropped, 0);
+}
+
+static void test_repeat(void) {
+    uint32_t edge_ms;
+    uint32_t next_ms;
+    uint16_t interval = 100;
+
+    setup();
+    keypad.hold_ms = 0;
+    tm1638_keypad_set_repeat(&keypad, 0x04, 300, 100, 40);
+    run(0, 10);
+
+    // S3 repeats 300 ms after the press, then ever faster down to 40 ms
+    edge_ms = now_ms + 1;
+    run(0x04, TM1638_DEBOUNCE_MS + 1);
+    expect(3, TM1638_KEY_PRESS, edge_ms);
+    next_ms = edge_ms + 300;
+    for (uint8_t n = 0; n < 12; n++) {
+        run(0x04, next_ms - now_ms - 1);
+        expect_none();
+        run(0x04, 1);
+        expect(3, TM1638_KEY_REPEAT, next_ms);
+        next_ms += interval;
+        interval -= interval / 8;
+        interval = (interval > 40) ? interval : 40;
+    }
+    CHECK_EQ(interval, 40);
+
+    // Released 5 ms before the next repeat: the repeat falls inside the
+    // release's debounce time and must not be sent
+    run(0x04, next_ms - now_ms - 5);
+    edge_ms = now_ms + 1;
+    run(0x00, TM1638_DEBOUNCE_MS + 1);
+    expect(3, TM1638_KEY_RELEASE, edge_ms);
+    run(0x00, 500);
+    expect_none();
+
+    // The next press starts again from the delay and the first interval
+    edge_ms = now_ms + 1;
+    run(0x04, 401);
+    expect(3, TM1638_KEY_PRESS, edge_ms);
+    expect(3, TM1638_KEY_REPEAT, edge_ms + 300);
+    expect(3, TM1638_KEY_REPEAT, edge_ms + 400);
+    expect_none();
+
+    // Keys not in the repeat mask never repeat
+    run(0x00, TM1638_DEBOUNCE_MS + 1);
+    expect(3, TM1638_KEY_RELEASE, edge_ms + 401);
+    edge_ms = now_ms + 1;
+    run(0x01, 1000);
+    expect(1, TM1638_KEY_PRESS, edge_ms);
+    expect_none();
+    CHECK_EQ(keypad.dropped, 0);
+}
+
+static void test_chord(void) {
+    uint32_t edge_ms;
+
+    setup();
+    keypad.hold_ms = 0;
+    CHECK_EQ(tm1638_keypad_add_chord(&keypad, 0x81), 1);
+    run(0, 10);
+
+    // S1 then S8: both presses, then the chord once S8 is accepted
+    edge_ms = now_ms + 1;
+    run(0x01, 50);
+    expect(1, TM1638_KEY_PRESS, edge_ms);
+    edge_ms = now_ms + 1;
+    run(0x81, TM1638_DEBOUNCE_MS + 1);
+    expect(8, TM1638_KEY_PRESS, edge_ms);
+    expect(1, TM1638_KEY_CHORD, edge_ms + TM1638_DEBOUNCE_MS);
+    run(0x81, 200);
+    expect_none();
+
+    // Releasing one key ends the chord; pressing it again sends it again
+    edge_ms = now_ms + 1;
+    run(0x01, TM1638_DEBOUNCE_MS + 1);
+    expect(8, TM1638_KEY_RELEASE, edge_ms);
+    expect_none();
+    edge_ms = now_ms + 1;
+    run(0x81, TM1638_DEBOUNCE_MS + 1);
+    expect(8, TM1638_KEY_PRESS, edge_ms);
+    expect(1, TM1638_KEY_CHORD, edge_ms + TM1638_DEBOUNCE_MS);
+
+    // Released together: two releases, no chord event
+    edge_ms = now_ms + 1;
+    run(0x00, TM1638_DEBOUNCE_MS + 1);
+    expect(1, TM1638_KEY_RELEASE, edge_ms);
+    expect(8, TM1638_KEY_RELEASE, edge_ms);
+    expect_none();
+
+    // Pressed together, with another key down as well: presses first, then the chord
+    edge_ms = now_ms + 1;
+    run(0x83, TM1638_DEBOUNCE_MS + 1);
+    expect(1, TM1638_KEY_PRESS, edge_ms);
+    expect(2, TM1638_KEY_PRESS, edge_ms);
+    expect(8, TM1638_KEY_PRESS, edge_ms);
+    expect(1, TM1638_KEY_CHORD, edge_ms + TM1638_DEBOUNCE_MS);
+    expect_none();
+    CHECK_EQ(keypad.dropped, 0);
+}
+
+static void test_wait(void) {
+    TM1638_KeyEvent event;
+    uint32_t start;
+    uint32_t cycles;
+    uint32_t duty;
+
+    setup();
+    keypad.hold_ms = 0;
+    CHECK_EQ(tm1638_wait_duty_permille(&keypad), 0);
+
+    // Idle: a scan every idle_scan_ms with the core asleep in between, until the timeout
+    HAL_Delay(TM1638_ACTIVE_HOLDOFF_MS);
+    tm1638_sim_reset_counters(&sim);
+    start = HAL_GetTick();
+    cycles = tm1638_mock_cycles();
+    CHECK(!tm1638_wait_event(&keypad, &event, 120));
+    cycles = tm1638_mock_cycles() - cycles;
+    CHECK_EQ(HAL_GetTick() - start, 120);
+    CHECK_EQ(sim.frames, 4);
+    CHECK_EQ(keypad.wait_ms, 120);
+
+    // CYCCNT stops in __WFI(), so only the scans count as awake
+    CHECK(keypad.awake_cycles > 0);
+    CHECK(keypad.awake_cycles <= cycles);
+    CHECK(keypad.awake_cycles + 8 >= cycles);
+    CHECK_EQ(tm1638_wait_duty_permille(&keypad), keypad.awake_cycles * 1000U / (120U * (SystemCoreClock / 1000U)));
+
+    // A zero timeout scans once and returns
+    start = HAL_GetTick();
+    CHECK(!tm1638_wait_event(&keypad, &event, 0));
+    CHECK_EQ(HAL_GetTick(), start);
+    CHECK_EQ(sim.frames, 5);
+
+    // A key already down wakes the wait: scans every active_scan_ms until
+    // the press is debounced, stamped with the first scan
+    run(0x01, 0);
+    tm1638_sim_reset_counters(&sim);
+    start = HAL_GetTick();
+    CHECK(tm1638_wait_event(&keypad, &event, 1000));
+    CHECK_EQ(event.key, 1);
+    CHECK_EQ(event.type, TM1638_KEY_PRESS);
+    CHECK_EQ(event.time_ms, start);
+    CHECK_EQ(HAL_GetTick() - start, TM1638_DEBOUNCE_MS);
+    CHECK_EQ(sim.frames, TM1638_DEBOUNCE_MS / TM1638_ACTIVE_SCAN_MS + 1);
+    CHECK_EQ(keypad.wait_ms, 120 + TM1638_DEBOUNCE_MS);
+
+    // Slow wiring: each scan takes longer, and the awake share with it. The
+    // release comes after the same five scans, so the duty is their share
+    // of the 20 ms waited
+    tm1638_set_timing(&display, 5000, 5000);
+    cycles = tm1638_mock_cycles();
+    (void)tm1638_scan_buttons(&display);
+    cycles = tm1638_mock_cycles() - cycles;
+    keypad.awake_cycles = 0;
+    keypad.wait_ms = 0;
+    run(0x00, 0);
+    CHECK(tm1638_wait_event(&keypad, &event, 1000));
+    CHECK_EQ(event.type, TM1638_KEY_RELEASE);
+    CHECK_EQ(keypad.wait_ms, TM1638_DEBOUNCE_MS);
+    duty = (uint32_t)((TM1638_DEBOUNCE_MS / TM1638_ACTIVE_SCAN_MS + 1) * cycles * 1000U
+                      / (TM1638_DEBOUNCE_MS * (SystemCoreClock / 1000U)));
+    CHECK_EQ(tm1638_wait_duty_permille(&keypad), duty);
+    CHECK(duty > 0);
+    CHECK_EQ(keypad.dropped, 0);
+    CHECK_EQ(sim.twait_errors, 0);
+}
+
+int main(void) {
+    test_bounce();
+    test_hold();
+    test_repeat();
+    test_chord();
+    test_wait();
+    return CHECK_DONE("test_keypad");
+}
@@ -0,0 +1,91 @@
+/**
+ * @file test_keys.c
+ * @brief Checks tm1638_scan_buttons() against the datasheet mapping for all 256 key combinations.
+ *
+ * The keys are pressed on the chip model, read back over the register
+ * transport and decoded by the driver. Every combination is repeated with
+ * the other keys of the matrix (K1/K3 and the unused S2 column bits) pressed
+ * in random patterns, which the decode must ignore.
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+#include <string.h>
+#include "TM1638.h"
+#include "TM1638_sim.h"
+#include "tm1638_mock.h"
+#include "check.h"
+
+/** @brief Noise patterns per key combination, the first one being none. */
+#define NOISE_RUNS 16
+
+static TM1638 display;
+static TM1638_Sim sim;
+
+/** @brief Matrix bit of S1-S8 (K2 line), from the datasheet's key table. */
+static const uint8_t key_bits[8] = {1, 9, 17, 25, 5, 13, 21, 29};
+
+/**
+ * @brief The decode tm1638_scan_buttons() had before, one test per key.
+ */
+static uint8_t reference_decode(uint32_t matrix) {
+    uint8_t keys = 0;
+
+    for (uint8_t i = 0; i < 8; i++) {
+        if (matrix & (1UL << key_bits[i])) {
+            keys |= (uint8_t)(1U << i);
+        }
+    }
+    return keys;
+}
+
+int main(void) {
+    GPIO_InitTypeDef init = {GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2, GPIO_MODE_OUTPUT_PP,
+                             GPIO_NOPULL, GPIO_SPEED_FREQ_VERY_HIGH, 0};
+    uint32_t lcg = 12345U;
+    uint32_t matrix_bits = 0;
+
+    for (uint8_t i = 0; i < 8; i++) {
+        matrix_bits |= 1UL << key_bits[i];
+    }
+
+    tm1638_mock_init();
+    HAL_GPIO_WritePin(GPIOA, init.Pin, GPIO_PIN_SET);
+    HAL_GPIO_Init(GPIOA, &init);
+    tm1638_sim_init(&sim);
+    tm1638_mock_connect(&sim, GPIOA, GPIO_PIN_0, GPIOA, GPIO_PIN_1, GPIOA, GPIO_PIN_2);
+    display.clk_port = GPIOA;
+    display.clk_pin = GPIO_PIN_0;
+    display.dio_port = GPIOA;
+    display.dio_pin = GPIO_PIN_1;
+    display.stb_port = GPIOA;
+    display.stb_pin = GPIO_PIN_2;
+    tm1638_init_transport(&display, &tm1638_transport_reg, 7);
+
+    for (uint32_t keys = 0; keys < 256; keys++) {
+        uint32_t pressed = 0;
+
+        for (uint8_t i = 0; i < 8; i++) {
+            if (keys & (1UL << i)) {
+                pressed |= 1UL << key_bits[i];
+            }
+        }
+        for (uint32_t run = 0; run < NOISE_RUNS; run++) {
+            uint32_t noise = 0;
+            uint32_t matrix;
+
+            if (run != 0) {
+                lcg = lcg * 1664525U + 1013904223U;
+                noise = lcg & ~matrix_bits;
+            }
+            // The chip only has bits 0-2 and 4-6 of each byte
+            matrix = (pressed | noise) & 0x77777777UL;
+            tm1638_sim_set_keys(&sim, matrix);
+            CHECK_EQ(reference_decode(matrix), keys);
+            CHECK_EQ(tm1638_scan_buttons(&display), keys);
+        }
+    }
+    CHECK_EQ(sim.errors, 0);
+
+    return CHECK_DONE("test_keys");
+}
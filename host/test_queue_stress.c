@@ -0,0 +1,81 @@
+/**
+ * @file test_queue_stress.c
+ * @brief Two-thread stress test of the keypad event ring, meant to run under ThreadSanitizer.
+ *
+ * A producer thread plays the scanning interrupt: it feeds S1 pressed and
+ * released every 25 ms of virtual time through tm1638_keypad_update(),
+ * yielding now and then so the threads interleave. The main thread consumes
+ * with tm1638_get_event() like the main loop would. Every event must be an
+ * S1 press or release stamped at its edge, in order, and the events read
+ * plus the dropped ones must add up to the edges fed.
+ *
+ * Built with the driver's TM1638_NO_HAL part only: make -C host stress
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <sched.h>
+#include "TM1638.h"
+#include "check.h"
+
+/** @brief Virtual milliseconds fed by the producer. */
+#define STRESS_MS 200000U
+
+/** @brief Time between S1 edges. */
+#define STRESS_PERIOD_MS 25U
+
+static TM1638 display;
+static TM1638_Keypad keypad;
+static int producer_done;
+
+static void *producer(void *arg) {
+    (void)arg;
+    for (uint32_t t = 1; t <= STRESS_MS; t++) {
+        if (t % STRESS_PERIOD_MS == 0) {
+            sched_yield();
+        }
+        tm1638_keypad_update(&keypad, (t / STRESS_PERIOD_MS) & 1U, t);
+    }
+    __atomic_store_n(&producer_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+int main(void) {
+    pthread_t thread;
+    TM1638_KeyEvent event;
+    uint32_t last_ms = 0;
+    uint32_t received = 0;
+
+    tm1638_keypad_init(&keypad, &display, &tm1638_board_led_key);
+    keypad.debounce_ms[0] = 0;
+    keypad.hold_ms = 0;
+
+    CHECK(pthread_create(&thread, NULL, producer, NULL) == 0);
+    for (;;) {
+        // Read done before polling, so nothing published before it is missed
+        int done = __atomic_load_n(&producer_done, __ATOMIC_ACQUIRE);
+
+        if (tm1638_get_event(&keypad, &event)) {
+            TM1638_KeyEventType type = ((event.time_ms / STRESS_PERIOD_MS) & 1U) ? TM1638_KEY_PRESS
+                                                                                  : TM1638_KEY_RELEASE;
+            CHECK_EQ(event.key, 1);
+            CHECK_EQ(event.type, type);
+            CHECK_EQ(event.time_ms % STRESS_PERIOD_MS, 0);
+            CHECK(event.time_ms > last_ms);
+            last_ms = event.time_ms;
+            received++;
+        } else if (done) {
+            break;
+        } else {
+            sched_yield();
+        }
+    }
+    CHECK(pthread_join(thread, NULL) == 0);
+
+    CHECK(received > 0);
+    CHECK_EQ(received + keypad.dropped, STRESS_MS / STRESS_PERIOD_MS);
+    printf("%u events, %u dropped\n", (unsigned)received, (unsigned)keypad.dropped);
+    return CHECK_DONE("test_queue_stress");
+}
@@ -0,0 +1,418 @@
+/**
+ * @file test_transports.c
+ * @brief Runs every STM32 transport of TM1638.c against chip models on the mock GPIO ports.
+ *
+ * Each case sets the pins up the way CubeMX-generated code does, connects
+ * TM1638_Sim models to them and checks that what the chips decoded matches
+ * the driver's framebuffer, and that key reads come back intact.
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+#include <string.h>
+#include "TM1638.h"
+#include "TM1638_sim.h"
+#include "tm1638_mock.h"
+#include "check.h"
+
+// Static so the timer + DMA transport gets 32-bit addresses
+static TM1638 display;
+static TM1638 modules[8];
+static TM1638_Sim sims[8];
+static SPI_HandleTypeDef hspi;
+static TIM_TypeDef tim;
+static TIM_HandleTypeDef htim = {&tim};
+static DMA_HandleTypeDef hdma;
+
+/**
+ * @brief Pins high, then outputs without pull, like generated MX_GPIO_Init() code.
+ */
+static void gpio_output(GPIO_TypeDef *port, uint16_t pins, bool open_drain) {
+    GPIO_InitTypeDef init = {pins, open_drain ? GPIO_MODE_OUTPUT_OD : GPIO_MODE_OUTPUT_PP,
+                             GPIO_NOPULL, GPIO_SPEED_FREQ_VERY_HIGH, 0};
+    HAL_GPIO_WritePin(port, pins, GPIO_PIN_SET);
+    HAL_GPIO_Init(port, &init);
+}
+
+/**
+ * @brief One module on PA0 (CLK), PA1 (DIO), PA2 (STB), with a model connected.
+ */
+static void setup_single(TM1638_Sim *sim, bool open_drain) {
+    tm1638_mock_init();
+    gpio_output(GPIOA, GPIO_PIN_0 | GPIO_PIN_2, false);
+    gpio_output(GPIOA, GPIO_PIN_1, open_drain);
+    tm1638_sim_init(sim);
+    tm1638_mock_connect(sim, GPIOA, GPIO_PIN_0, GPIOA, GPIO_PIN_1, GPIOA, GPIO_PIN_2);
+    memset(&display, 0, sizeof(display));
+    display.clk_port = GPIOA;
+    display.clk_pin = GPIO_PIN_0;
+    display.dio_port = GPIOA;
+    display.dio_pin = GPIO_PIN_1;
+    display.stb_port = GPIOA;
+    display.stb_pin = GPIO_PIN_2;
+}
+
+#ifdef TM1638_ENABLE_STATS
+/**
+ * @brief Checks that a handle counted every transaction and byte its model saw.
+ */
+static void check_stats(const TM1638 *tm, const TM1638_Sim *sim) {
+    TM1638_Stats stats;
+
+    tm1638_get_stats(tm, &stats);
+    CHECK_EQ(stats.transactions, sim->frames);
+    CHECK_EQ((stats.bytes_sent + stats.bytes_received) * 8, sim->bits);
+}
+#endif
+
+/**
+ * @brief Draws, flushes, reads keys and checks the chip agrees.
+ */
+static void exercise(TM1638 *tm, TM1638_Sim *sim) {
+    static const uint32_t patterns[] = {0x00000000UL, 0x00000002UL, 0x22222222UL, 0x77777777UL, 0x12345670UL};
+
+    CHECK(sim->display_on);
+    CHECK_EQ(sim->brightness, tm->brightness);
+
+    tm1638_display_txt(tm, "12.34");
+    tm1638_set_led(tm, 3, true);
+    tm1638_flush(tm);
+    CHECK(memcmp(sim->ram, tm->display_ram, sizeof(sim->ram)) == 0);
+    CHECK_EQ(tm1638_sim_segment(sim, 8), tm->display_ram[14]);
+    CHECK(tm1638_sim_led(sim, 3));
+
+    tm1638_display_char(tm, 1, 'A', true);
+    tm1638_flush(tm);
+    CHECK(memcmp(sim->ram, tm->display_ram, sizeof(sim->ram)) == 0);
+
+    tm1638_set_brightness(tm, 2);
+    CHECK_EQ(sim->brightness, 2);
+
+    for (size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+        tm1638_sim_set_keys(sim, patterns[i]);
+        CHECK_EQ(tm1638_scan_matrix(tm), patterns[i] & 0x77777777UL);
+    }
+    tm1638_sim_set_keys(sim, (1UL << 1) | (1UL << 29)); // S1 and S8 of LED&KEY
+    CHECK_EQ(tm1638_scan_buttons(tm), 0x81);
+
+    CHECK_EQ(sim->errors, 0);
+    CHECK_EQ(sim->twait_errors, 0);
+    CHECK_EQ(tm1638_mock_contentions(), 0);
+    CHECK(sim->stb);
+#ifdef TM1638_ENABLE_STATS
+    check_stats(tm, sim);
+#endif
+}
+
+static void test_hal(bool open_drain) {
+    setup_single(&sims[0], open_drain);
+    tm1638_init_transport(&display, &tm1638_transport_hal, 5);
+    CHECK_EQ(display.dio_open_drain, open_drain);
+    exercise(&display, &sims[0]);
+}
+
+static void test_reg(bool open_drain) {
+    setup_single(&sims[0], open_drain);
+    tm1638_init_transport(&display, &tm1638_transport_reg, 5);
+    CHECK_EQ(display.dio_open_drain, open_drain);
+    exercise(&display, &sims[0]);
+    // The push-pull read flipped DIO back to output, the open-drain one never left it
+    CHECK_EQ((GPIOA->MODER >> 2) & 0x3U, 1);
+}
+
+static void test_timing(void) {
+    setup_single(&sims[0], false);
+    tm1638_init_transport(&display, &tm1638_transport_reg, 5);
+    tm1638_set_timing(&display, 500, 500);
+    CHECK(display.clk_low_cycles > 0);
+    exercise(&display, &sims[0]);
+
+    // Slow wiring: reads only pass once the CLK low time covers the settling time
+    setup_single(&sims[0], false);
+    tm1638_init_transport(&display, &tm1638_transport_reg, 5);
+    tm1638_mock_set_settle_ns(300);
+    uint32_t ns = tm1638_calibrate_timing(&display, 50);
+    CHECK(ns != UINT32_MAX && ns >= 300);
+    exercise(&display, &sims[0]);
+
+    // Slower than the datasheet's floor: 400 ns fails, 800 ns is kept with the margin
+    setup_single(&sims[0], false);
+    tm1638_init_transport(&display, &tm1638_transport_reg, 5);
+    tm1638_mock_set_settle_ns(500);
+    CHECK_EQ(tm1638_calibrate_timing(&display, 50), 1200);
+    exercise(&display, &sims[0]);
+
+    // Ideal wiring would pass at full speed but stops at 400 ns per phase
+    setup_single(&sims[0], false);
+    tm1638_init_transport(&display, &tm1638_transport_reg, 5);
+    CHECK_EQ(tm1638_calibrate_timing(&display, 50), 600);
+    CHECK(display.clk_low_cycles >= 50); // 600 ns at 84 MHz
+}
+
+/**
+ * @brief Changes one display register through the API, so it becomes dirty.
+ */
+static void touch(TM1638 *tm, uint8_t reg) {
+    if (reg & 1U) {
+        tm1638_set_led(tm, (uint8_t)((reg + 1) / 2), (tm->display_ram[reg] & 0x01) == 0);
+    } else {
+        tm1638_set_segment(tm, (uint8_t)(reg / 2 + 1), tm->display_ram[reg] ^ 0x01);
+    }
+}
+
+/**
+ * @brief Flushes and checks the frames and bits the planner put on the bus.
+ */
+static void check_flush(TM1638 *tm, TM1638_Sim *sim, uint32_t frames, uint32_t bits, bool fixed) {
+    tm1638_sim_reset_counters(sim);
+    tm1638_flush(tm);
+    CHECK_EQ(sim->frames, frames);
+    CHECK_EQ(sim->bits, bits);
+    CHECK_EQ(sim->fixed_address, fixed);
+    CHECK(memcmp(sim->ram, tm->display_ram, sizeof(sim->ram)) == 0);
+}
+
+static void test_flush_plan(void) {
+    setup_single(&sims[0], false);
+    tm1638_init_transport(&display, &tm1638_transport_reg, 5);
+
+    // Two scattered LEDs: one fixed-address (0x44) frame each, after the data command
+    tm1638_set_led(&display, 1, true);
+    tm1638_set_led(&display, 8, true);
+    check_flush(&display, &sims[0], 3, 8 + 2 * 16, true);
+
+    // Two registers with a gap: the gap is resent when that is not dearer than
+    // another STB cycle plus address byte, else each gets its own frame
+    for (uint8_t gap = 1; gap <= 4; gap++) {
+        bool merged = gap * 8 <= TM1638_STB_CYCLE_COST + 8;
+        touch(&display, 1);
+        touch(&display, (uint8_t)(gap + 2));
+        if (merged) {
+            check_flush(&display, &sims[0], 2, 8 + 8 + (gap + 2) * 8U, false);
+        } else {
+            check_flush(&display, &sims[0], 3, 8 + 2 * 16, true);
+        }
+    }
+
+    // A run and a lone register: auto-increment, one frame per run
+    touch(&display, 1);
+    touch(&display, 2);
+    touch(&display, 10);
+    check_flush(&display, &sims[0], 3, 8 + (8 + 16) + (8 + 8), false);
+
+    // Dense update: all 8 digits in one burst from address 0 to 14
+    tm1638_display_txt(&display, "12345678");
+    check_flush(&display, &sims[0], 2, 8 + 8 + 15 * 8, false);
+    CHECK_EQ(sims[0].errors, 0);
+}
+
+static void test_twait(void) {
+    TM1638_Sim *sim = &sims[1];
+    uint8_t cmd = 0x42;
+
+    // The model flags key data clocked straight after the read command
+    tm1638_sim_init(sim);
+    tm1638_sim_pins(sim, true, true, false);
+    for (uint8_t i = 0; i < 8; i++) {
+        tm1638_sim_pins(sim, false, ((cmd >> i) & 1U) != 0, false);
+        tm1638_sim_pins(sim, true, ((cmd >> i) & 1U) != 0, false);
+    }
+    tm1638_sim_pins(sim, false, true, false);
+    CHECK_EQ(sim->twait_errors, 1);
+    tm1638_sim_pins(sim, true, true, true);
+
+    // The simulator transport waits
+    memset(&modules[0], 0, sizeof(modules[0]));
+    tm1638_sim_attach(&modules[0], sim, 5);
+    tm1638_sim_set_keys(sim, 0x22222222UL);
+    CHECK_EQ(tm1638_scan_matrix(&modules[0]), 0x22222222UL);
+    CHECK_EQ(sim->twait_errors, 1);
+
+    // And so do the STM32 transports, on the mock's clock
+    setup_single(&sims[0], false);
+    tm1638_init_transport(&display, &tm1638_transport_hal, 5);
+    CHECK(display.twait_cycles >= 84); // 1 us at 84 MHz
+    (void)tm1638_scan_matrix(&display);
+    setup_single(&sims[0], false);
+    tm1638_init_transport(&display, &tm1638_transport_reg, 5);
+    (void)tm1638_scan_matrix(&display);
+    CHECK_EQ(sims[0].twait_errors, 0);
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *spi) {
+    if (spi == display.hspi) {
+        tm1638_spi_tx_complete(&display);
+    }
+}
+
+static void test_spi(void) {
+    GPIO_InitTypeDef af = {GPIO_PIN_5 | GPIO_PIN_7, GPIO_MODE_AF_PP, GPIO_NOPULL, GPIO_SPEED_FREQ_VERY_HIGH, 5};
+
+    tm1638_mock_init();
+    gpio_output(GPIOA, GPIO_PIN_4, false);
+    HAL_GPIO_Init(GPIOA, &af);
+    tm1638_mock_spi_pins(&hspi, GPIOA, GPIO_PIN_5, GPIO_PIN_7);
+    tm1638_sim_init(&sims[0]);
+    tm1638_mock_connect(&sims[0], GPIOA, GPIO_PIN_5, GPIOA, GPIO_PIN_7, GPIOA, GPIO_PIN_4);
+
+    memset(&display, 0, sizeof(display));
+    display.hspi = &hspi;
+    display.dio_port = GPIOA; // MOSI, so init pulls it up
+    display.dio_pin = GPIO_PIN_7;
+    display.stb_port = GPIOA;
+    display.stb_pin = GPIO_PIN_4;
+    tm1638_init_transport(&display, &tm1638_transport_spi, 5);
+    CHECK_EQ((GPIOA->PUPDR >> 14) & 0x3U, 1);
+    exercise(&display, &sims[0]);
+
+    // A failed transmit aborts the SPI; the next command goes out again
+    tm1638_mock_fail_spi(1);
+    tm1638_set_brightness(&display, 6);
+    CHECK_EQ(tm1638_mock_spi_aborts(), 1);
+    tm1638_set_brightness(&display, 4);
+    CHECK_EQ(sims[0].brightness, 4);
+}
+
+static void setup_tim_dma(void) {
+    setup_single(&sims[0], false);
+    memset(&tim, 0, sizeof(tim));
+    memset(&hdma, 0, sizeof(hdma));
+    display.htim = &htim;
+    display.hdma = &hdma;
+    tm1638_init_transport(&display, &tm1638_transport_tim_dma, 5);
+}
+
+static void test_tim_dma(void) {
+    setup_tim_dma();
+    exercise(&display, &sims[0]);
+    CHECK(!display.tx_busy);
+    CHECK(!tm1638_mock_timer_running());
+
+    // A transfer error ends the frame and frees the bus
+    tm1638_mock_fail_dma(20);
+    tm1638_display_txt(&display, "Err");
+    tm1638_flush(&display);
+    CHECK(!display.tx_busy);
+    CHECK(!tm1638_mock_timer_running());
+    CHECK(sims[0].stb);
+    CHECK(sims[0].clk);
+    tm1638_display_txt(&display, "ok");
+    display.dirty = 0xFFFF;
+    tm1638_flush(&display);
+    CHECK(memcmp(sims[0].ram, display.display_ram, sizeof(sims[0].ram)) == 0);
+}
+
+static void test_bus(void) {
+    TM1638_Bus bus;
+
+    tm1638_mock_init();
+    gpio_output(GPIOA, GPIO_PIN_0 | GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4, false);
+    gpio_output(GPIOA, GPIO_PIN_1, false);
+    memset(modules, 0, sizeof(modules));
+    for (uint8_t i = 0; i < 3; i++) {
+        tm1638_sim_init(&sims[i]);
+        tm1638_mock_connect(&sims[i], GPIOA, GPIO_PIN_0, GPIOA, GPIO_PIN_1, GPIOA, (uint16_t)(GPIO_PIN_2 << i));
+        modules[i].stb_port = GPIOA;
+        modules[i].stb_pin = (uint16_t)(GPIO_PIN_2 << i);
+    }
+    modules[0].clk_port = GPIOA;
+    modules[0].clk_pin = GPIO_PIN_0;
+    modules[0].dio_port = GPIOA;
+    modules[0].dio_pin = GPIO_PIN_1;
+
+    CHECK(!tm1638_bus_init(&bus, modules, 3, &tm1638_transport_spi, 5));
+    CHECK_EQ(bus.count, 0);
+    CHECK(tm1638_bus_init(&bus, modules, 3, &tm1638_transport_reg, 5));
+
+    tm1638_bus_set_brightness(&bus, 2);
+    tm1638_display_txt(&modules[1], "bus");
+    tm1638_bus_flush(&bus);
+    for (uint8_t i = 0; i < 3; i++) {
+        CHECK_EQ(sims[i].brightness, 2);
+        CHECK(memcmp(sims[i].ram, modules[i].display_ram, sizeof(sims[i].ram)) == 0);
+        CHECK_EQ(sims[i].errors, 0);
+    }
+    tm1638_sim_set_keys(&sims[1], 1UL << 9);
+    CHECK_EQ(tm1638_scan_buttons(&modules[1]), 0x02);
+    CHECK_EQ(tm1638_scan_buttons(&modules[0]), 0x00);
+    CHECK_EQ(tm1638_mock_contentions(), 0);
+}
+
+static void test_parallel(void) {
+    TM1638_Parallel par;
+    char text[4] = "P0";
+
+    tm1638_mock_init();
+    gpio_output(GPIOB, 0x03FF, false); // PB0 CLK, PB1-PB8 DIO, PB9 shared STB
+    memset(modules, 0, sizeof(modules));
+    for (uint8_t i = 0; i < 8; i++) {
+        tm1638_sim_init(&sims[i]);
+        tm1638_mock_connect(&sims[i], GPIOB, GPIO_PIN_0, GPIOB, (uint16_t)(GPIO_PIN_1 << i), GPIOB, GPIO_PIN_9);
+        modules[i].clk_port = modules[i].dio_port = modules[i].stb_port = GPIOB;
+        modules[i].clk_pin = GPIO_PIN_0;
+        modules[i].dio_pin = (uint16_t)(GPIO_PIN_1 << i);
+        modules[i].stb_pin = GPIO_PIN_9;
+    }
+
+    // Refused groups never touch the bus: no modules, a module on another port
+    CHECK(!tm1638_parallel_init(&par, modules, 0, 3));
+    CHECK(!tm1638_parallel_init(&par, modules, TM1638_PARALLEL_MAX_MODULES + 1, 3));
+    modules[3].dio_port = GPIOC;
+    CHECK(!tm1638_parallel_init(&par, modules, 8, 3));
+    CHECK_EQ(par.count, 0);
+    tm1638_parallel_flush(&par);
+    tm1638_parallel_set_brightness(&par, 3);
+    CHECK_EQ(sims[0].frames, 0);
+    modules[3].dio_port = GPIOB;
+
+    // Out-of-range brightness is clamped, not masked
+    CHECK(tm1638_parallel_init(&par, modules, 8, 9));
+    CHECK_EQ(sims[0].brightness, 7);
+    CHECK_EQ(modules[0].brightness, 7);
+
+    for (uint8_t i = 0; i < 8; i++) {
+        text[1] = (char)('0' + i);
+        tm1638_display_txt(&modules[i], text);
+        tm1638_set_led(&modules[i], (uint8_t)(i + 1), true);
+    }
+    tm1638_parallel_flush(&par);
+    tm1638_set_timing(&modules[0], 200, 200);
+    tm1638_display_char(&modules[5], 1, '5', false);
+    tm1638_parallel_flush(&par);
+    tm1638_parallel_set_brightness(&par, 6);
+    for (uint8_t i = 0; i < 8; i++) {
+        CHECK(memcmp(sims[i].ram, modules[i].display_ram, sizeof(sims[i].ram)) == 0);
+        CHECK_EQ(sims[i].brightness, 6);
+        CHECK(sims[i].display_on);
+        CHECK_EQ(sims[i].errors, 0);
+#ifdef TM1638_ENABLE_STATS
+        // Group passes count as each module's flush and brightness change, init's included
+        TM1638_Stats stats;
+        tm1638_get_stats(&modules[i], &stats);
+        CHECK_EQ(stats.flush.count, 3);
+        CHECK_EQ(stats.brightness.count, 2);
+        check_stats(&modules[i], &sims[i]);
+#endif
+    }
+}
+
+int main(void) {
+    test_hal(false);
+    test_hal(true);
+    test_reg(false);
+    test_reg(true);
+    test_timing();
+    test_flush_plan();
+    test_twait();
+    test_spi();
+    test_tim_dma();
+    test_bus();
+    test_parallel();
+#if defined(TM1638_USE_TX_TABLE)
+    return CHECK_DONE("test_transports (TX table)");
+#elif defined(TM1638_ENABLE_STATS)
+    return CHECK_DONE("test_transports (stats)");
+#else
+    return CHECK_DONE("test_transports");
+#endif
+}
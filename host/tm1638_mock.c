@@ -0,0 +1,577 @@
+/**
+ * @file tm1638_mock.c
+ * @brief Host HAL mock: GPIO ports, virtual clock, SPI, timer and DMA models.
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+#define _GNU_SOURCE
+#include "tm1638_mock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// --- Private Constant Definitions ---
+
+/** @brief Mocked ports GPIOA..GPIOE, 0x400 bytes apart. */
+#define MOCK_PORTS 5
+#define MOCK_PORT_SIZE 0x400UL
+
+/** @brief Word offsets of the registers within a port. */
+#define REG_MODER 0
+#define REG_OTYPER 1
+#define REG_PUPDR 3
+#define REG_IDR 4
+#define REG_ODR 5
+#define REG_BSRR 6
+
+/** @brief Timer period used when ARR is not set (2 MHz update rate at 84 MHz). */
+#define MOCK_TIMER_CYCLES 42
+
+typedef enum {
+    DRIVE_RELEASED,
+    DRIVE_LOW,
+    DRIVE_HIGH
+} Drive;
+
+typedef struct {
+    TM1638_Sim *sim;
+    uint8_t clk_port, dio_port, stb_port;
+    uint16_t clk_pin, dio_pin, stb_pin;
+    uint64_t clk_fall_ns; // Time of the last falling CLK edge seen by the chip
+} MockChip;
+
+typedef struct {
+    SPI_HandleTypeDef *hspi;
+    uint8_t port;
+    uint16_t sck_pin, mosi_pin;
+} MockSpi;
+
+// --- Private Variables ---
+
+uint32_t SystemCoreClock = 84000000U;
+DWT_Type tm1638_mock_dwt;
+CoreDebug_Type tm1638_mock_core_debug;
+
+static uint64_t mock_cycles;
+static uint64_t mock_sleep_cycles;
+static uint32_t mock_accesses;
+static uint32_t mock_contentions;
+static uint32_t mock_spi_aborts;
+static uint32_t mock_settle_ns;
+static uint32_t mock_noise = 1;
+
+static MockChip mock_chips[TM1638_MOCK_MAX_CHIPS];
+static uint8_t mock_chip_count;
+
+// Levels driven by alternate function pins (SPI), and the pins the SPI has released
+static uint16_t mock_af_high[MOCK_PORTS];
+static uint16_t mock_af_released[MOCK_PORTS];
+static MockSpi mock_spi[2];
+static uint8_t mock_spi_count;
+static uint8_t mock_spi_fail;
+
+// Armed DMA transfer, started by the next timer start
+static DMA_HandleTypeDef *mock_dma;
+static uint32_t mock_dma_src, mock_dma_dst, mock_dma_len;
+static uint32_t mock_dma_fail_after = UINT32_MAX;
+static bool mock_timer_running;
+
+// --- Private Function Prototypes ---
+
+static volatile uint32_t *mock_reg(uint8_t port, uint8_t reg);
+static bool mock_decode(const volatile uint32_t *reg, uint8_t *port, uint8_t *index);
+static Drive mock_drive(uint8_t port, uint8_t pin);
+static bool mock_line(uint8_t port, uint8_t pin);
+static void mock_port_changed(uint8_t port);
+static uint8_t mock_pin_index(uint16_t pin);
+static uint64_t mock_now_ns(void);
+static void mock_advance(uint32_t cycles);
+
+// --- Port memory ---
+
+/**
+ * @brief Maps the port registers at their STM32 addresses before main() runs.
+ */
+__attribute__((constructor)) static void mock_map_ports(void) {
+    void *base = mmap((void *)AHB1PERIPH_BASE, MOCK_PORTS * MOCK_PORT_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (base != (void *)AHB1PERIPH_BASE) {
+        fprintf(stderr, "tm1638_mock: cannot map the GPIO ports at 0x%08lX\n", AHB1PERIPH_BASE);
+        abort();
+    }
+}
+
+// --- Public Function Implementation ---
+
+/**
+ * @brief Resets ports, clock, peripheral models and fault injection; disconnects all chips.
+ */
+void tm1638_mock_init(void) {
+    memset((void *)AHB1PERIPH_BASE, 0, MOCK_PORTS * MOCK_PORT_SIZE);
+    memset(&tm1638_mock_dwt, 0, sizeof(tm1638_mock_dwt));
+    memset(&tm1638_mock_core_debug, 0, sizeof(tm1638_mock_core_debug));
+    mock_cycles = 0;
+    mock_sleep_cycles = 0;
+    mock_accesses = 0;
+    mock_contentions = 0;
+    mock_spi_aborts = 0;
+    mock_settle_ns = 0;
+    mock_chip_count = 0;
+    memset(mock_af_high, 0, sizeof(mock_af_high));
+    memset(mock_af_released, 0, sizeof(mock_af_released));
+    mock_spi_count = 0;
+    mock_spi_fail = 0;
+    mock_dma = NULL;
+    mock_dma_fail_after = UINT32_MAX;
+    mock_timer_running = false;
+}
+
+/**
+ * @brief Connects a chip model to three pins.
+ * @return true on success, false if the chip table is full.
+ */
+bool tm1638_mock_connect(TM1638_Sim *sim, GPIO_TypeDef *clk_port, uint16_t clk_pin,
+                         GPIO_TypeDef *dio_port, uint16_t dio_pin,
+                         GPIO_TypeDef *stb_port, uint16_t stb_pin) {
+    MockChip *chip;
+    uint8_t index;
+
+    if (mock_chip_count == TM1638_MOCK_MAX_CHIPS) {
+        return false;
+    }
+    chip = &mock_chips[mock_chip_count++];
+    chip->sim = sim;
+    mock_decode(&clk_port->MODER, &chip->clk_port, &index);
+    mock_decode(&dio_port->MODER, &chip->dio_port, &index);
+    mock_decode(&stb_port->MODER, &chip->stb_port, &index);
+    chip->clk_pin = clk_pin;
+    chip->dio_pin = dio_pin;
+    chip->stb_pin = stb_pin;
+    chip->clk_fall_ns = 0;
+    sim->step_ns = 0;
+    sim->time_ns = mock_now_ns();
+    return true;
+}
+
+/**
+ * @brief Routes an SPI handle to its SCK and MOSI pins.
+ */
+void tm1638_mock_spi_pins(SPI_HandleTypeDef *hspi, GPIO_TypeDef *port, uint16_t sck_pin, uint16_t mosi_pin) {
+    MockSpi *spi = &mock_spi[mock_spi_count < 2 ? mock_spi_count++ : 1];
+    uint8_t index;
+
+    spi->hspi = hspi;
+    mock_decode(&port->MODER, &spi->port, &index);
+    spi->sck_pin = sck_pin;
+    spi->mosi_pin = mosi_pin;
+    // CPOL high: SCK idles high; MOSI idles high
+    mock_af_high[spi->port] |= sck_pin | mosi_pin;
+}
+
+void tm1638_mock_set_settle_ns(uint32_t ns) {
+    mock_settle_ns = ns;
+}
+
+void tm1638_mock_fail_spi(uint8_t count) {
+    mock_spi_fail = count;
+}
+
+void tm1638_mock_fail_dma(uint32_t after_words) {
+    mock_dma_fail_after = after_words;
+}
+
+uint64_t tm1638_mock_time_ns(void) {
+    return mock_now_ns();
+}
+
+uint32_t tm1638_mock_accesses(void) {
+    return mock_accesses;
+}
+
+uint32_t tm1638_mock_contentions(void) {
+    return mock_contentions;
+}
+
+uint32_t tm1638_mock_spi_aborts(void) {
+    return mock_spi_aborts;
+}
+
+bool tm1638_mock_timer_running(void) {
+    return mock_timer_running;
+}
+
+// --- Register access ---
+
+/**
+ * @brief Stores to a register; BSRR updates ODR, pin setup changes reach the chips.
+ */
+void tm1638_mock_store(volatile uint32_t *reg, uint32_t value) {
+    uint8_t port;
+    uint8_t index;
+
+    mock_advance(TM1638_MOCK_ACCESS_CYCLES);
+    mock_accesses++;
+    if (!mock_decode(reg, &port, &index)) {
+        *reg = value; // Not a port register
+        return;
+    }
+    switch (index) {
+    case REG_BSRR: {
+        volatile uint32_t *odr = mock_reg(port, REG_ODR);
+        // Set wins over reset when a pin is in both halves
+        *odr = ((*odr & ~(value >> 16)) | value) & 0xFFFFU;
+        break;
+    }
+    case REG_IDR:
+        return; // Read-only
+    default:
+        *reg = value;
+        break;
+    }
+    mock_port_changed(port);
+}
+
+/**
+ * @brief Loads a register; IDR returns the line levels.
+ */
+uint32_t tm1638_mock_load(const volatile uint32_t *reg) {
+    uint8_t port;
+    uint8_t index;
+    uint32_t idr = 0;
+
+    mock_advance(TM1638_MOCK_ACCESS_CYCLES);
+    mock_accesses++;
+    if (!mock_decode(reg, &port, &index)) {
+        return *reg;
+    }
+    switch (index) {
+    case REG_IDR:
+        for (uint8_t pin = 0; pin < 16; pin++) {
+            idr |= (uint32_t)mock_line(port, pin) << pin;
+        }
+        return idr;
+    case REG_BSRR:
+        return 0; // Write-only
+    default:
+        return *reg;
+    }
+}
+
+uint32_t tm1638_mock_cycles(void) {
+    mock_advance(1);
+    return (uint32_t)(mock_cycles - mock_sleep_cycles);
+}
+
+// --- HAL GPIO ---
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init) {
+    for (uint8_t pin = 0; pin < 16; pin++) {
+        uint32_t mask = 0x3UL << (2 * pin);
+        if (!(GPIO_Init->Pin & (1U << pin))) {
+            continue;
+        }
+        tm1638_mock_store(&GPIOx->OTYPER, (GPIOx->OTYPER & ~(1UL << pin))
+                          | (((GPIO_Init->Mode >> 4) & 1U) << pin));
+        tm1638_mock_store(&GPIOx->PUPDR, (GPIOx->PUPDR & ~mask) | (GPIO_Init->Pull << (2 * pin)));
+        tm1638_mock_store(&GPIOx->MODER, (GPIOx->MODER & ~mask) | ((GPIO_Init->Mode & 0x3U) << (2 * pin)));
+    }
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+    mock_advance(TM1638_MOCK_HAL_CALL_CYCLES);
+    tm1638_mock_store(&GPIOx->BSRR, (PinState != GPIO_PIN_RESET) ? GPIO_Pin : (uint32_t)GPIO_Pin << 16);
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin) {
+    mock_advance(TM1638_MOCK_HAL_CALL_CYCLES);
+    return (tm1638_mock_load(&GPIOx->IDR) & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+// --- HAL system ---
+
+uint32_t HAL_GetTick(void) {
+    return (uint32_t)(mock_cycles / (SystemCoreClock / 1000U));
+}
+
+void HAL_Delay(uint32_t Delay) {
+    mock_advance(Delay * (SystemCoreClock / 1000U));
+}
+
+void __WFI(void) {
+    // The next SysTick interrupt wakes the core; DWT->CYCCNT stops meanwhile
+    uint32_t tick = SystemCoreClock / 1000U;
+    uint32_t cycles = (uint32_t)(tick - mock_cycles % tick);
+
+    mock_sleep_cycles += cycles;
+    mock_advance(cycles);
+}
+
+// --- HAL DMA and timer ---
+
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress,
+                                   uint32_t DstAddress, uint32_t DataLength) {
+    if (mock_dma != NULL) {
+        return HAL_BUSY;
+    }
+    mock_dma = hdma;
+    mock_dma_src = SrcAddress;
+    mock_dma_dst = DstAddress;
+    mock_dma_len = DataLength;
+    return HAL_OK;
+}
+
+/**
+ * @brief Starts the timer; with its update DMA request enabled, plays the armed transfer.
+ */
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim) {
+    DMA_HandleTypeDef *hdma = mock_dma;
+    uint32_t period = MOCK_TIMER_CYCLES;
+
+    mock_timer_running = true;
+    if (hdma == NULL || !(htim->Instance->DIER & TIM_DMA_UPDATE)) {
+        return HAL_OK;
+    }
+    if (htim->Instance->ARR != 0) {
+        period = (htim->Instance->PSC + 1U) * (htim->Instance->ARR + 1U);
+    }
+    for (uint32_t i = 0; i < mock_dma_len; i++) {
+        if (i == mock_dma_fail_after) {
+            mock_dma_fail_after = UINT32_MAX;
+            mock_dma = NULL;
+            if (hdma->XferErrorCallback != NULL) {
+                hdma->XferErrorCallback(hdma);
+            }
+            return HAL_OK;
+        }
+        mock_advance(period - TM1638_MOCK_ACCESS_CYCLES);
+        tm1638_mock_store((volatile uint32_t *)(uintptr_t)mock_dma_dst,
+                          ((const uint32_t *)(uintptr_t)mock_dma_src)[i]);
+    }
+    mock_dma = NULL;
+    if (hdma->XferCpltCallback != NULL) {
+        hdma->XferCpltCallback(hdma);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef *htim) {
+    (void)htim;
+    mock_timer_running = false;
+    return HAL_OK;
+}
+
+// --- HAL SPI ---
+
+/**
+ * @brief Finds the pins of an SPI handle.
+ */
+static MockSpi *mock_spi_find(SPI_HandleTypeDef *hspi) {
+    for (uint8_t i = 0; i < mock_spi_count; i++) {
+        if (mock_spi[i].hspi == hspi) {
+            return &mock_spi[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Drives an alternate function pin and lets the chips see it after half a clock.
+ */
+static void mock_spi_level(MockSpi *spi, uint16_t pin, bool high) {
+    mock_advance(TM1638_MOCK_SPI_HALF_CYCLES);
+    mock_af_released[spi->port] &= (uint16_t)~pin;
+    if (high) {
+        mock_af_high[spi->port] |= pin;
+    } else {
+        mock_af_high[spi->port] &= (uint16_t)~pin;
+    }
+    mock_port_changed(spi->port);
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    MockSpi *spi = mock_spi_find(hspi);
+    (void)Timeout;
+
+    if (spi == NULL || mock_spi_fail > 0) {
+        mock_spi_fail -= (mock_spi_fail > 0);
+        return HAL_ERROR;
+    }
+    mock_af_released[spi->port] &= (uint16_t)~spi->mosi_pin;
+    // LSB first, CPOL high, CPHA 2nd edge: data changes on the falling edge, latched on the rising one
+    for (uint16_t n = 0; n < Size; n++) {
+        for (uint8_t i = 0; i < 8; i++) {
+            mock_af_high[spi->port] = (uint16_t)((mock_af_high[spi->port] & ~spi->mosi_pin)
+                                                 | (((pData[n] >> i) & 1U) ? spi->mosi_pin : 0));
+            mock_spi_level(spi, spi->sck_pin, false);
+            mock_spi_level(spi, spi->sck_pin, true);
+        }
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    MockSpi *spi = mock_spi_find(hspi);
+    uint8_t mosi = mock_pin_index(spi != NULL ? spi->mosi_pin : 1);
+    (void)Timeout;
+
+    if (spi == NULL || mock_spi_fail > 0) {
+        mock_spi_fail -= (mock_spi_fail > 0);
+        return HAL_ERROR;
+    }
+    // Bidirectional mode turns the data line into an input
+    mock_af_released[spi->port] |= spi->mosi_pin;
+    mock_port_changed(spi->port);
+    for (uint16_t n = 0; n < Size; n++) {
+        uint8_t byte = 0;
+        for (uint8_t i = 0; i < 8; i++) {
+            mock_spi_level(spi, spi->sck_pin, false);
+            mock_spi_level(spi, spi->sck_pin, true);
+            if (mock_line(spi->port, mosi)) {
+                byte |= (uint8_t)(1U << i);
+            }
+        }
+        pData[n] = byte;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size) {
+    HAL_StatusTypeDef status = HAL_SPI_Transmit(hspi, pData, Size, HAL_MAX_DELAY);
+    if (status == HAL_OK) {
+        HAL_SPI_TxCpltCallback(hspi);
+    }
+    return status;
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi) {
+    (void)hspi;
+    mock_spi_aborts++;
+    return HAL_OK;
+}
+
+__attribute__((weak)) void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+    (void)hspi;
+}
+
+// --- Private Helper Function Implementation ---
+
+static volatile uint32_t *mock_reg(uint8_t port, uint8_t reg) {
+    return (volatile uint32_t *)(AHB1PERIPH_BASE + port * MOCK_PORT_SIZE) + reg;
+}
+
+/**
+ * @brief Splits a register address into port number and register index.
+ * @return false if the address is not inside a mocked port.
+ */
+static bool mock_decode(const volatile uint32_t *reg, uint8_t *port, uint8_t *index) {
+    uintptr_t offset = (uintptr_t)reg - AHB1PERIPH_BASE;
+    if ((uintptr_t)reg < AHB1PERIPH_BASE || offset >= MOCK_PORTS * MOCK_PORT_SIZE) {
+        return false;
+    }
+    *port = (uint8_t)(offset / MOCK_PORT_SIZE);
+    *index = (uint8_t)((offset % MOCK_PORT_SIZE) / 4);
+    return true;
+}
+
+/**
+ * @brief What the MCU does with a pin: drive it low, drive it high or leave it.
+ */
+static Drive mock_drive(uint8_t port, uint8_t pin) {
+    uint32_t mode = (*mock_reg(port, REG_MODER) >> (2 * pin)) & 0x3U;
+    bool open_drain = (*mock_reg(port, REG_OTYPER) >> pin) & 1U;
+    bool high;
+
+    if (mode == 1) {
+        high = (*mock_reg(port, REG_ODR) >> pin) & 1U;
+    } else if (mode == 2) {
+        if ((mock_af_released[port] >> pin) & 1U) {
+            return DRIVE_RELEASED;
+        }
+        high = (mock_af_high[port] >> pin) & 1U;
+    } else {
+        return DRIVE_RELEASED; // Input or analog
+    }
+    if (!high) {
+        return DRIVE_LOW;
+    }
+    return open_drain ? DRIVE_RELEASED : DRIVE_HIGH;
+}
+
+/**
+ * @brief Level of a line: MCU, chips on it (wired AND) and pull resistor.
+ */
+static bool mock_line(uint8_t port, uint8_t pin) {
+    Drive drive = mock_drive(port, pin);
+    bool chip_low = false;
+
+    for (uint8_t c = 0; c < mock_chip_count; c++) {
+        MockChip *chip = &mock_chips[c];
+        bool out;
+        if (chip->dio_port != port || chip->dio_pin != (1U << pin)) {
+            continue;
+        }
+        out = chip->sim->dio_out;
+        if (chip->sim->reading && mock_now_ns() - chip->clk_fall_ns < mock_settle_ns) {
+            // Bit not settled on the wire yet
+            mock_noise = mock_noise * 1103515245U + 12345U;
+            out = (mock_noise >> 16) & 1U;
+        }
+        chip_low |= !out;
+    }
+    if (drive == DRIVE_LOW) {
+        return false;
+    }
+    if (drive == DRIVE_HIGH) {
+        return true; // Contention with a chip is counted by mock_port_changed()
+    }
+    if (chip_low) {
+        return false;
+    }
+    return ((*mock_reg(port, REG_PUPDR) >> (2 * pin)) & 0x3U) == 1U; // Floating reads 0
+}
+
+/**
+ * @brief Presents the new levels to every chip with a pin on the port.
+ */
+static void mock_port_changed(uint8_t port) {
+    for (uint8_t c = 0; c < mock_chip_count; c++) {
+        MockChip *chip = &mock_chips[c];
+        uint8_t dio = mock_pin_index(chip->dio_pin);
+        bool clk;
+        bool stb;
+        Drive drive;
+
+        if (chip->clk_port != port && chip->dio_port != port && chip->stb_port != port) {
+            continue;
+        }
+        clk = mock_line(chip->clk_port, mock_pin_index(chip->clk_pin));
+        stb = mock_line(chip->stb_port, mock_pin_index(chip->stb_pin));
+        drive = mock_drive(chip->dio_port, dio);
+        if (chip->sim->clk && !clk) {
+            chip->clk_fall_ns = mock_now_ns();
+        }
+        chip->sim->time_ns = mock_now_ns();
+        tm1638_sim_pins(chip->sim, clk, drive != DRIVE_LOW, stb);
+        if (drive == DRIVE_HIGH && !chip->sim->dio_out) {
+            mock_contentions++;
+        }
+    }
+}
+
+static uint8_t mock_pin_index(uint16_t pin) {
+    uint8_t index = 0;
+    while (((uint32_t)pin >> index) > 1U) {
+        index++;
+    }
+    return index;
+}
+
+static uint64_t mock_now_ns(void) {
+    return mock_cycles * 1000000000ULL / SystemCoreClock;
+}
+
+static void mock_advance(uint32_t cycles) {
+    mock_cycles += cycles;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file tm1638_mock.h
+ * @brief Control of the host HAL mock: chips on the pins, virtual clock and fault injection.
+ *
+ * The mock keeps the GPIO ports of stm32f4xx_hal.h in memory at their real
+ * addresses and evaluates the pin levels after every register access. Chips
+ * connected with tm1638_mock_connect() see their CLK, DIO and STB lines on
+ * each store to one of their ports, so the driver's transports are decoded
+ * by TM1638_Sim exactly as the chip would see them.
+ *
+ * Line model: a pin is driven by its MODER/OTYPER/ODR setup (alternate
+ * function pins by the SPI model), a chip pulls its DIO low while it shifts
+ * out a 0, and a line nobody drives follows PUPDR; a floating line reads 0,
+ * so a missing pull-up shows up as lost key bits.
+ *
+ * Time model: a virtual core clock at SystemCoreClock advances by
+ * TM1638_MOCK_ACCESS_CYCLES per register access, by one per DWT->CYCCNT read,
+ * by one timer period per DMA word and by half an SPI clock per SPI edge.
+ * HAL_GetTick() and __WFI() follow it, and the connected models get it as
+ * their time_ns, so VCD files show the real edge timing. As on the core,
+ * DWT->CYCCNT stops while __WFI() sleeps.
+ *
+ * Programs using the timer + DMA transport must be linked without PIE and
+ * keep their TM1638 handles static, since the DMA API takes 32-bit addresses.
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+
+#ifndef TM1638_MOCK_H_
+#define TM1638_MOCK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "stm32f4xx_hal.h"
+#include "TM1638_sim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Virtual core cycles per GPIO register access. */
+#ifndef TM1638_MOCK_ACCESS_CYCLES
+#define TM1638_MOCK_ACCESS_CYCLES 2
+#endif
+
+/** @brief Extra virtual cycles per HAL_GPIO_WritePin() / HAL_GPIO_ReadPin() call. */
+#ifndef TM1638_MOCK_HAL_CALL_CYCLES
+#define TM1638_MOCK_HAL_CALL_CYCLES 10
+#endif
+
+/** @brief Virtual cycles per half SPI clock (1 MHz SCK at 84 MHz). */
+#ifndef TM1638_MOCK_SPI_HALF_CYCLES
+#define TM1638_MOCK_SPI_HALF_CYCLES 42
+#endif
+
+/** @brief Chips the mock can connect at once. */
+#define TM1638_MOCK_MAX_CHIPS 8
+
+/**
+ * @brief Resets the ports (all pins inputs without pull, ODR 0), the clock,
+ *        the SPI and DMA models, the fault injection and disconnects all chips.
+ */
+void tm1638_mock_init(void);
+
+/**
+ * @brief Connects a chip model to three pins.
+ *
+ * The model's time_ns then follows the virtual clock; open its VCD file with
+ * a step_ns of 0 to keep it that way.
+ *
+ * @param sim Pointer to an initialized model.
+ * @param clk_port Port of the CLK pin.
+ * @param clk_pin CLK pin mask.
+ * @param dio_port Port of the DIO pin.
+ * @param dio_pin DIO pin mask.
+ * @param stb_port Port of the STB pin.
+ * @param stb_pin STB pin mask.
+ * @return true on success, false if TM1638_MOCK_MAX_CHIPS are connected.
+ */
+bool tm1638_mock_connect(TM1638_Sim *sim, GPIO_TypeDef *clk_port, uint16_t clk_pin,
+                         GPIO_TypeDef *dio_port, uint16_t dio_pin,
+                         GPIO_TypeDef *stb_port, uint16_t stb_pin);
+
+/**
+ * @brief Routes an SPI handle to its SCK and MOSI pins (configure them as alternate function).
+ * @param hspi SPI handle passed to the driver.
+ * @param port Port of both pins.
+ * @param sck_pin SCK pin mask.
+ * @param mosi_pin MOSI pin mask.
+ */
+void tm1638_mock_spi_pins(SPI_HandleTypeDef *hspi, GPIO_TypeDef *port, uint16_t sck_pin, uint16_t mosi_pin);
+
+/**
+ * @brief Models the wiring: a key bit read sooner than this after the falling
+ *        CLK edge is not settled yet and reads as noise.
+ * @param ns Settling time in nanoseconds (0: ideal wiring).
+ */
+void tm1638_mock_set_settle_ns(uint32_t ns);
+
+/**
+ * @brief Makes the next SPI calls fail with HAL_ERROR without touching the pins.
+ * @param count Number of calls to fail.
+ */
+void tm1638_mock_fail_spi(uint8_t count);
+
+/**
+ * @brief Makes the next DMA transfer stop with a transfer error.
+ * @param after_words Words moved before the error.
+ */
+void tm1638_mock_fail_dma(uint32_t after_words);
+
+/**
+ * @brief Virtual time since tm1638_mock_init().
+ * @return Nanoseconds.
+ */
+uint64_t tm1638_mock_time_ns(void);
+
+/**
+ * @brief Register accesses (loads and stores) since tm1638_mock_init().
+ * @return The access count.
+ */
+uint32_t tm1638_mock_accesses(void);
+
+/**
+ * @brief Times the MCU drove a DIO line high push-pull while a chip pulled it low.
+ * @return The contention count.
+ */
+uint32_t tm1638_mock_contentions(void);
+
+/**
+ * @brief HAL_SPI_Abort() calls since tm1638_mock_init().
+ * @return The abort count.
+ */
+uint32_t tm1638_mock_spi_aborts(void);
+
+/**
+ * @brief Whether the timer started by the DMA transport is still running.
+ * @return true while running.
+ */
+bool tm1638_mock_timer_running(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TM1638_MOCK_H_ */
@@ -0,0 +1,113 @@
+/**
+ * @file vcd_dump.c
+ * @brief Records the bus waveform of each STM32 transport as a VCD file.
+ *
+ * The mock HAL feeds every GPIO register access to the chip model, which
+ * writes the line changes with the virtual clock as time base. Each file
+ * holds the same sequence: init, a text flush, an LED flush and a key scan
+ * with S1 down, so the transports can be compared side by side in GTKWave
+ * or PulseView.
+ *
+ * Usage: vcd_dump [directory]   (default: current directory)
+ *
+ * @version 1.1
+ * @date 2025-10-05
+ */
+#include <stdio.h>
+#include <string.h>
+#include "TM1638.h"
+#include "TM1638_sim.h"
+#include "tm1638_mock.h"
+
+// Static so the timer + DMA transport gets 32-bit addresses
+static TM1638 display;
+static TM1638_Sim sim;
+static SPI_HandleTypeDef hspi;
+static TIM_TypeDef tim;
+static TIM_HandleTypeDef htim = {&tim};
+static DMA_HandleTypeDef hdma;
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *spi) {
+    if (spi == display.hspi) {
+        tm1638_spi_tx_complete(&display);
+    }
+}
+
+/**
+ * @brief Pins high, then push-pull outputs (or alternate function) without pull.
+ */
+static void gpio_init(uint16_t pins, uint32_t mode) {
+    GPIO_InitTypeDef init = {pins, mode, GPIO_NOPULL, GPIO_SPEED_FREQ_VERY_HIGH, 5};
+    HAL_GPIO_WritePin(GPIOA, pins, GPIO_PIN_SET);
+    HAL_GPIO_Init(GPIOA, &init);
+}
+
+/**
+ * @brief Records one transport; CLK/DIO/STB are PA0/PA1/PA2, or PA5/PA7/PA4 for SPI.
+ * @return false if nothing or something wrong reached the chip.
+ */
+static bool record(const char *dir, const char *name, const TM1638_Transport *transport) {
+    char path[256];
+    FILE *out;
+    bool spi = (transport == &tm1638_transport_spi);
+    bool ok;
+
+    tm1638_mock_init();
+    memset(&display, 0, sizeof(display));
+    tm1638_sim_init(&sim);
+    if (spi) {
+        gpio_init(GPIO_PIN_4, GPIO_MODE_OUTPUT_PP);
+        gpio_init(GPIO_PIN_5 | GPIO_PIN_7, GPIO_MODE_AF_PP);
+        tm1638_mock_spi_pins(&hspi, GPIOA, GPIO_PIN_5, GPIO_PIN_7);
+        tm1638_mock_connect(&sim, GPIOA, GPIO_PIN_5, GPIOA, GPIO_PIN_7, GPIOA, GPIO_PIN_4);
+        display.hspi = &hspi;
+        display.dio_pin = GPIO_PIN_7;
+        display.stb_pin = GPIO_PIN_4;
+    } else {
+        gpio_init(GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2, GPIO_MODE_OUTPUT_PP);
+        tm1638_mock_connect(&sim, GPIOA, GPIO_PIN_0, GPIOA, GPIO_PIN_1, GPIOA, GPIO_PIN_2);
+        display.clk_port = GPIOA;
+        display.clk_pin = GPIO_PIN_0;
+        display.dio_pin = GPIO_PIN_1;
+        display.stb_pin = GPIO_PIN_2;
+        display.htim = &htim;
+        display.hdma = &hdma;
+    }
+    display.dio_port = GPIOA;
+    display.stb_port = GPIOA;
+
+    snprintf(path, sizeof(path), "%s/%s.vcd", dir, name);
+    out = fopen(path, "w");
+    if (out == NULL) {
+        perror(path);
+        return false;
+    }
+    tm1638_sim_vcd_open(&sim, out, 0); // Time from the mock's virtual clock
+
+    tm1638_init_transport(&display, transport, 7);
+    tm1638_display_txt(&display, "12.34");
+    tm1638_flush(&display);
+    tm1638_set_led(&display, 1, true);
+    tm1638_flush(&display);
+    tm1638_sim_set_keys(&sim, 1UL << 1);
+    ok = tm1638_scan_buttons(&display) == 0x01;
+
+    tm1638_sim_vcd_close(&sim);
+    fclose(out);
+
+    ok = ok && sim.errors == 0 && sim.edges > 0 && memcmp(sim.ram, display.display_ram, sizeof(sim.ram)) == 0;
+    printf("%-22s %6u edges %5u bits %3u frames %8.1f us%s\n", path, sim.edges, sim.bits, sim.frames,
+           tm1638_mock_time_ns() / 1000.0, ok ? "" : "  FAILED");
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    const char *dir = (argc > 1) ? argv[1] : ".";
+    bool ok = true;
+
+    ok &= record(dir, "hal", &tm1638_transport_hal);
+    ok &= record(dir, "reg", &tm1638_transport_reg);
+    ok &= record(dir, "spi", &tm1638_transport_spi);
+    ok &= record(dir, "tim_dma", &tm1638_transport_tim_dma);
+    return ok ? 0 : 1;
+}